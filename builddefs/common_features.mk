@@ -45,6 +45,17 @@ else ifeq ($(strip $(DEBUG_MATRIX_SCAN_RATE_ENABLE)), api)
     OPT_DEFS += -DDEBUG_MATRIX_SCAN_RATE
 endif
 
+ifeq ($(strip $(MATRIX_IDLE_ENABLE)), yes)
+    OPT_DEFS += -DMATRIX_IDLE_ENABLE
+    SRC += $(QUANTUM_DIR)/matrix_idle.c
+endif
+
+ifeq ($(strip $(DEFERRED_LOG_ENABLE)), yes)
+    OPT_DEFS += -DDEFERRED_LOG_ENABLE
+    SRC += $(QUANTUM_DIR)/logging/deferred_log.c
+    CONSOLE_ENABLE = yes
+endif
+
 AUDIO_ENABLE ?= no
 ifeq ($(strip $(AUDIO_ENABLE)), yes)
     ifeq ($(PLATFORM),CHIBIOS)
@@ -465,7 +476,7 @@ ifeq ($(strip $(SLEEP_LED_ENABLE)), yes)
     NO_SUSPEND_POWER_DOWN := yes
 endif
 
-VALID_BACKLIGHT_TYPES := pwm timer software custom
+VALID_BACKLIGHT_TYPES := pwm timer software dma custom
 
 BACKLIGHT_ENABLE ?= no
 ifeq ($(strip $(CONVERT_TO_PROTON_C)), yes)
@@ -740,6 +751,13 @@ ifeq ($(strip $(PS2_USE_USART)), yes)
     OPT_DEFS += -DPS2_USE_USART
 endif
 
+ifeq ($(strip $(PS2_USE_DMA)), yes)
+    PS2_ENABLE := yes
+    SRC += ps2_dma.c
+    SRC += ps2_io.c
+    OPT_DEFS += -DPS2_USE_DMA
+endif
+
 ifeq ($(strip $(PS2_ENABLE)), yes)
     COMMON_VPATH += $(DRIVER_PATH)/ps2
     COMMON_VPATH += $(PLATFORM_PATH)/$(PLATFORM_KEY)/$(DRIVER_DIR)/ps2
@@ -37,6 +37,9 @@ GENERIC_FEATURES = \
     VELOCIKEY \
     WPM \
     DYNAMIC_TAPPING_TERM \
+    PREDICTIVE_TAP_HOLD \
+    TASK_SCHEDULER \
+    STAGED_INIT \
 
 define HANDLE_GENERIC_FEATURE
     # $$(info "Processing: $1_ENABLE $2.c")
@@ -40,6 +40,11 @@ OTHER_OPTION_NAMES = \
   AUTO_SHIFT_ENABLE \
   AUTO_SHIFT_MODIFIERS \
   DYNAMIC_TAPPING_TERM_ENABLE \
+  PREDICTIVE_TAP_HOLD_ENABLE \
+  TASK_SCHEDULER_ENABLE \
+  STAGED_INIT_ENABLE \
+  DEFERRED_LOG_ENABLE \
+  MATRIX_IDLE_ENABLE \
   COMBO_ENABLE \
   KEY_LOCK_ENABLE \
   KEY_OVERRIDE_ENABLE \
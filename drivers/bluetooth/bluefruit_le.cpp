@@ -32,6 +32,11 @@
 #    define BLUEFRUIT_LE_SCK_DIVISOR 2 // 4MHz SCK/8MHz CPU, calculated for Feather 32U4 BLE
 #endif
 
+// Number of commands sent to the module before waiting for the first response
+#ifndef BLUEFRUIT_LE_PIPELINE_DEPTH
+#    define BLUEFRUIT_LE_PIPELINE_DEPTH 2
+#endif
+
 #define SAMPLE_BATTERY
 #define ConnectionUpdateInterval 1000 /* milliseconds */
 
@@ -53,6 +58,7 @@ static struct {
     uint32_t vbat;
 #endif
     uint16_t last_connection_update;
+    uint8_t  mouse_buttons;
 } state;
 
 // Commands are encoded using SDEP and sent via SPI
@@ -75,6 +81,10 @@ struct sdep_msg {
 // a short queue for that.  Since there is quite a lot of space overhead for
 // the AT command representation wrapped up in SDEP, we queue the minimal
 // information here.
+// Reports that are still queued are coalesced with newer ones where that does
+// not lose a key event. If the queue is full anyway, one report of each type
+// waits in an overflow slot instead of blocking the caller, and only a report
+// that cannot be folded into it losslessly waits for the module.
 
 enum queue_type {
     QTKeyReport, // 1-byte modifier + 6-byte key report
@@ -82,16 +92,19 @@ enum queue_type {
 #ifdef MOUSE_ENABLE
     QTMouseMove, // 4-byte mouse report
 #endif
+    QTCount,
+};
+
+struct __attribute__((packed)) key_state {
+    uint8_t modifier;
+    uint8_t keys[6];
 };
 
 struct queue_item {
     enum queue_type queue_type;
     uint16_t        added;
     union __attribute__((packed)) {
-        struct __attribute__((packed)) {
-            uint8_t modifier;
-            uint8_t keys[6];
-        } key;
+        struct key_state key;
 
         uint16_t consumer;
         struct __attribute__((packed)) {
@@ -103,10 +116,17 @@ struct queue_item {
 
 // Items that we wish to send
 static RingBuffer<queue_item, 40> send_buf;
-// Pending response; while pending, we can't send any more requests.
-// This records the time at which we sent the command for which we
+// Pending responses; while full, we can't send any more requests.
+// This records the times at which we sent the commands for which we
 // are expecting a response.
-static RingBuffer<uint16_t, 2> resp_buf;
+static RingBuffer<uint16_t, BLUEFRUIT_LE_PIPELINE_DEPTH + 1> resp_buf;
+
+// Newest report of each type that did not fit in send_buf
+static struct queue_item overflow[QTCount];
+static uint8_t           overflow_mask;
+
+// The most recently queued key state, and the state before it
+static struct key_state key_queued, key_prior;
 
 static bool process_queue_item(struct queue_item *item, uint16_t timeout);
 
@@ -257,25 +277,150 @@ static void resp_buf_read_one(bool greedy) {
     }
 }
 
-static void send_buf_send_one(uint16_t timeout = SdepTimeout) {
+static bool send_buf_send_one(uint16_t timeout = SdepTimeout) {
     struct queue_item item;
 
-    // Don't send anything more until we get an ACK
-    if (!resp_buf.empty()) {
-        return;
+    // Don't send anything more until the pipeline has room
+    if (resp_buf.full()) {
+        return false;
     }
 
-    if (!send_buf.peek(item)) {
-        return;
+    if (send_buf.empty()) {
+        return false;
     }
-    if (process_queue_item(&item, timeout)) {
+    // Sent in place, so that a partially sent mouse report is not repeated
+    if (process_queue_item(&send_buf.front(), timeout)) {
         // commit that peek
         send_buf.get(item);
         dprintf("send_buf_send_one: have %d remaining\n", (int)send_buf.size());
+        return true;
+    }
+    dprint("failed to send, will retry\n");
+    resp_buf_read_one(true);
+    return false;
+}
+
+static bool key_state_has(const struct key_state *s, uint8_t key) {
+    for (uint8_t i = 0; i < sizeof(s->keys); i++) {
+        if (s->keys[i] == key) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Whether `back` can be replaced by `next` without losing a press or release
+// that `back` makes relative to `prior`, e.g. a quick tap queued as two reports.
+static bool key_state_can_merge(const struct key_state *prior, const struct key_state *back, const struct key_state *next) {
+    if ((back->modifier & ~prior->modifier & ~next->modifier) || (prior->modifier & ~back->modifier & next->modifier)) {
+        return false;
+    }
+    for (uint8_t i = 0; i < sizeof(back->keys); i++) {
+        uint8_t key = back->keys[i];
+        if (key && !key_state_has(prior, key) && !key_state_has(next, key)) {
+            return false;
+        }
+        key = prior->keys[i];
+        if (key && !key_state_has(back, key) && key_state_has(next, key)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+#ifdef MOUSE_ENABLE
+static bool fits_int8(int8_t a, int8_t b) {
+    int16_t sum = a + b;
+    return sum >= INT8_MIN && sum <= INT8_MAX;
+}
+#endif
+
+// Fold `item` into `back`, a report of the same type queued after `prior`,
+// if no press or release is lost doing so
+static bool queue_item_merge(struct queue_item *back, const struct key_state *prior, const struct queue_item *item) {
+    switch (item->queue_type) {
+        case QTKeyReport:
+            if (!key_state_can_merge(prior, &back->key, &item->key)) {
+                return false;
+            }
+            back->key = item->key;
+            return true;
+
+#ifdef MOUSE_ENABLE
+        case QTMouseMove:
+            if (back->mousemove.buttons != item->mousemove.buttons || !fits_int8(back->mousemove.x, item->mousemove.x) || !fits_int8(back->mousemove.y, item->mousemove.y) || !fits_int8(back->mousemove.scroll, item->mousemove.scroll) || !fits_int8(back->mousemove.pan, item->mousemove.pan)) {
+                return false;
+            }
+            back->mousemove.x += item->mousemove.x;
+            back->mousemove.y += item->mousemove.y;
+            back->mousemove.scroll += item->mousemove.scroll;
+            back->mousemove.pan += item->mousemove.pan;
+            return true;
+#endif
+
+        default:
+            return false;
+    }
+}
+
+// Fold `item` into the last queued report of the same type
+static bool send_buf_merge(const struct queue_item *item) {
+    if (send_buf.empty() || send_buf.back().queue_type != item->queue_type) {
+        return false;
+    }
+    return queue_item_merge(&send_buf.back(), &key_prior, item);
+}
+
+// Wait for the module until send_buf can take another report
+static void send_buf_make_room(void) {
+    if (send_buf.full()) {
+        dprint("send_buf full, waiting\n");
+    }
+    while (send_buf.full()) {
+        if (!send_buf_send_one()) {
+            resp_buf_read_one(true);
+        }
+    }
+}
+
+// Queue a report, only waiting for the module when it cannot be held back
+// without losing a press or release
+static void send_buf_enqueue(const struct queue_item *item) {
+    uint8_t            bit  = 1 << item->queue_type;
+    struct queue_item *slot = &overflow[item->queue_type];
+
+    if (overflow_mask & bit) {
+        // Stay behind the report already waiting
+        if (queue_item_merge(slot, &key_queued, item)) {
+            return;
+        }
+        overflow_mask &= ~bit;
+        send_buf_make_room();
+        send_buf_enqueue(slot);
+    }
+
+    if (send_buf_merge(item)) {
+        if (item->queue_type == QTKeyReport) {
+            key_queued = item->key;
+        }
+    } else if (send_buf.enqueue(*item)) {
+        if (item->queue_type == QTKeyReport) {
+            key_prior  = key_queued;
+            key_queued = item->key;
+        }
     } else {
-        dprint("failed to send, will retry\n");
-        wait_ms(SdepTimeout);
-        resp_buf_read_one(true);
+        dprint("send_buf full, holding report\n");
+        *slot = *item;
+        overflow_mask |= bit;
+    }
+}
+
+static void send_buf_flush_overflow(void) {
+    for (uint8_t type = 0; overflow_mask && type < QTCount; type++) {
+        if ((overflow_mask & (1 << type)) && !send_buf.full()) {
+            overflow_mask &= ~(1 << type);
+            send_buf_enqueue(&overflow[type]);
+        }
     }
 }
 
@@ -291,9 +436,10 @@ static void resp_buf_wait(const char *cmd) {
 }
 
 static bool ble_init(void) {
-    state.initialized  = false;
-    state.configured   = false;
-    state.is_connected = false;
+    state.initialized   = false;
+    state.configured    = false;
+    state.is_connected  = false;
+    state.mouse_buttons = 0;
 
     setPinInput(BLUEFRUIT_LE_IRQ_PIN);
 
@@ -509,7 +655,10 @@ void bluefruit_le_task(void) {
         return;
     }
     resp_buf_read_one(true);
-    send_buf_send_one(SdepShortTimeout);
+    send_buf_flush_overflow();
+    while (send_buf_send_one(SdepShortTimeout)) {
+        // keep the pipeline full
+    }
 
     if (resp_buf.empty() && (state.event_flags & UsingEvents) && readPin(BLUEFRUIT_LE_IRQ_PIN)) {
         // Must be an event update
@@ -562,9 +711,33 @@ void bluefruit_le_task(void) {
 #endif
 }
 
+static char *append_hex8(char *dest, uint8_t value) {
+    static const char hex[] PROGMEM = "0123456789abcdef";
+    *dest++ = pgm_read_byte(&hex[value >> 4]);
+    *dest++ = pgm_read_byte(&hex[value & 0xF]);
+    return dest;
+}
+
+#ifdef MOUSE_ENABLE
+static char *append_int8(char *dest, int8_t value) {
+    uint8_t magnitude = value < 0 ? -(int16_t)value : value;
+    if (value < 0) {
+        *dest++ = '-';
+    }
+    if (magnitude >= 100) {
+        *dest++ = '0' + magnitude / 100;
+    }
+    if (magnitude >= 10) {
+        *dest++ = '0' + magnitude / 10 % 10;
+    }
+    *dest++ = '0' + magnitude % 10;
+    return dest;
+}
+#endif
+
 static bool process_queue_item(struct queue_item *item, uint16_t timeout) {
-    char cmdbuf[48];
-    char fmtbuf[64];
+    char  cmdbuf[48];
+    char *p;
 
     // Arrange to re-check connection after keys have settled
     state.last_connection_update = timer_read();
@@ -575,23 +748,54 @@ static bool process_queue_item(struct queue_item *item, uint16_t timeout) {
     }
 #endif
 
+    // The commands are assembled by hand rather than with snprintf, this runs for every report
     switch (item->queue_type) {
-        case QTKeyReport:
-            strcpy_P(fmtbuf, PSTR("AT+BLEKEYBOARDCODE=%02x-00-%02x-%02x-%02x-%02x-%02x-%02x"));
-            snprintf(cmdbuf, sizeof(cmdbuf), fmtbuf, item->key.modifier, item->key.keys[0], item->key.keys[1], item->key.keys[2], item->key.keys[3], item->key.keys[4], item->key.keys[5]);
+        case QTKeyReport: {
+            // Trailing empty key slots may be left out, which keeps most reports within two SDEP packets
+            uint8_t nkeys = sizeof(item->key.keys);
+            while (nkeys > 0 && item->key.keys[nkeys - 1] == 0) {
+                nkeys--;
+            }
+            strcpy_P(cmdbuf, PSTR("AT+BLEKEYBOARDCODE="));
+            p    = append_hex8(cmdbuf + strlen(cmdbuf), item->key.modifier);
+            *p++ = '-';
+            *p++ = '0';
+            *p++ = '0';
+            for (uint8_t i = 0; i < nkeys; i++) {
+                *p++ = '-';
+                p    = append_hex8(p, item->key.keys[i]);
+            }
+            *p = 0;
             return at_command(cmdbuf, NULL, 0, true, timeout);
+        }
 
         case QTConsumer:
-            strcpy_P(fmtbuf, PSTR("AT+BLEHIDCONTROLKEY=0x%04x"));
-            snprintf(cmdbuf, sizeof(cmdbuf), fmtbuf, item->consumer);
+            strcpy_P(cmdbuf, PSTR("AT+BLEHIDCONTROLKEY=0x"));
+            p  = append_hex8(cmdbuf + strlen(cmdbuf), item->consumer >> 8);
+            p  = append_hex8(p, item->consumer & 0xFF);
+            *p = 0;
             return at_command(cmdbuf, NULL, 0, true, timeout);
 
 #ifdef MOUSE_ENABLE
         case QTMouseMove:
-            strcpy_P(fmtbuf, PSTR("AT+BLEHIDMOUSEMOVE=%d,%d,%d,%d"));
-            snprintf(cmdbuf, sizeof(cmdbuf), fmtbuf, item->mousemove.x, item->mousemove.y, item->mousemove.scroll, item->mousemove.pan);
-            if (!at_command(cmdbuf, NULL, 0, true, timeout)) {
-                return false;
+            if (item->mousemove.x || item->mousemove.y || item->mousemove.scroll || item->mousemove.pan) {
+                strcpy_P(cmdbuf, PSTR("AT+BLEHIDMOUSEMOVE="));
+                p    = append_int8(cmdbuf + strlen(cmdbuf), item->mousemove.x);
+                *p++ = ',';
+                p    = append_int8(p, item->mousemove.y);
+                *p++ = ',';
+                p    = append_int8(p, item->mousemove.scroll);
+                *p++ = ',';
+                p    = append_int8(p, item->mousemove.pan);
+                *p   = 0;
+                if (!at_command(cmdbuf, NULL, 0, true, timeout)) {
+                    return false;
+                }
+                // Sent, a retry only has to deal with the buttons
+                item->mousemove.x = item->mousemove.y = item->mousemove.scroll = item->mousemove.pan = 0;
+            }
+            if (item->mousemove.buttons == state.mouse_buttons) {
+                return true;
             }
             strcpy_P(cmdbuf, PSTR("AT+BLEHIDMOUSEBUTTON="));
             if (item->mousemove.buttons & MOUSE_BTN1) {
@@ -606,7 +810,11 @@ static bool process_queue_item(struct queue_item *item, uint16_t timeout) {
             if (item->mousemove.buttons == 0) {
                 strcat(cmdbuf, "0");
             }
-            return at_command(cmdbuf, NULL, 0, true, timeout);
+            if (!at_command(cmdbuf, NULL, 0, true, timeout)) {
+                return false;
+            }
+            state.mouse_buttons = item->mousemove.buttons;
+            return true;
 #endif
         default:
             return true;
@@ -615,7 +823,6 @@ static bool process_queue_item(struct queue_item *item, uint16_t timeout) {
 
 void bluefruit_le_send_keys(uint8_t hid_modifier_mask, uint8_t *keys, uint8_t nkeys) {
     struct queue_item item;
-    bool              didWait = false;
 
     item.queue_type   = QTKeyReport;
     item.key.modifier = hid_modifier_mask;
@@ -629,14 +836,7 @@ void bluefruit_le_send_keys(uint8_t hid_modifier_mask, uint8_t *keys, uint8_t nk
         item.key.keys[4] = nkeys >= 4 ? keys[4] : 0;
         item.key.keys[5] = nkeys >= 5 ? keys[5] : 0;
 
-        if (!send_buf.enqueue(item)) {
-            if (!didWait) {
-                dprint("wait for buf space\n");
-                didWait = true;
-            }
-            send_buf_send_one();
-            continue;
-        }
+        send_buf_enqueue(&item);
 
         if (nkeys <= 6) {
             return;
@@ -652,10 +852,9 @@ void bluefruit_le_send_consumer_key(uint16_t usage) {
 
     item.queue_type = QTConsumer;
     item.consumer   = usage;
+    item.added      = timer_read();
 
-    while (!send_buf.enqueue(item)) {
-        send_buf_send_one();
-    }
+    send_buf_enqueue(&item);
 }
 
 #ifdef MOUSE_ENABLE
@@ -668,10 +867,9 @@ void bluefruit_le_send_mouse_move(int8_t x, int8_t y, int8_t scroll, int8_t pan,
     item.mousemove.scroll  = scroll;
     item.mousemove.pan     = pan;
     item.mousemove.buttons = buttons;
+    item.added             = timer_read();
 
-    while (!send_buf.enqueue(item)) {
-        send_buf_send_one();
-    }
+    send_buf_enqueue(&item);
 }
 #endif
 
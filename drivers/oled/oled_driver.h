@@ -170,6 +170,11 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #    define OLED_UPDATE_INTERVAL 50
 #endif
 
+// Upper bound on the bytes sent by one oled_render call, at least one block is always sent
+#if !defined(OLED_RENDER_CHUNK_SIZE)
+#    define OLED_RENDER_CHUNK_SIZE OLED_DISPLAY_WIDTH
+#endif
+
 typedef struct __attribute__((__packed__)) {
     uint8_t *current_element;
     uint16_t remaining_element_count;
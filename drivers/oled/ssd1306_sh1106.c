@@ -245,13 +245,14 @@ void oled_clear(void) {
     oled_dirty  = OLED_ALL_BLOCKS_MASK;
 }
 
-static void calc_bounds(uint8_t update_start, uint8_t *cmd_array) {
+static void calc_bounds(uint16_t start, uint16_t length, uint8_t *cmd_array) {
     // Calculate commands to set memory addressing bounds.
-    uint8_t start_page   = OLED_BLOCK_SIZE * update_start / OLED_DISPLAY_WIDTH;
-    uint8_t start_column = OLED_BLOCK_SIZE * update_start % OLED_DISPLAY_WIDTH;
+    uint8_t start_page   = start / OLED_DISPLAY_WIDTH;
+    uint8_t start_column = start % OLED_DISPLAY_WIDTH;
 #if (OLED_IC == OLED_IC_SH1106)
     // Commands for Page Addressing Mode. Sets starting page and column; has no end bound.
     // Column value must be split into high and low nybble and sent as two commands.
+    (void)length;
     cmd_array[0] = PAM_PAGE_ADDR | start_page;
     cmd_array[1] = PAM_SETCOLUMN_LSB | ((OLED_COLUMN_OFFSET + start_column) & 0x0f);
     cmd_array[2] = PAM_SETCOLUMN_MSB | ((OLED_COLUMN_OFFSET + start_column) >> 4 & 0x0f);
@@ -260,10 +261,11 @@ static void calc_bounds(uint8_t update_start, uint8_t *cmd_array) {
     cmd_array[5] = NOP;
 #else
     // Commands for use in Horizontal Addressing mode.
+    // A window starting in column 0 spans the full width, so it can wrap onto the following pages.
     cmd_array[1] = start_column;
     cmd_array[4] = start_page;
-    cmd_array[2] = (OLED_BLOCK_SIZE + OLED_DISPLAY_WIDTH - 1) % OLED_DISPLAY_WIDTH + cmd_array[1];
-    cmd_array[5] = (OLED_BLOCK_SIZE + OLED_DISPLAY_WIDTH - 1) / OLED_DISPLAY_WIDTH - 1;
+    cmd_array[2] = (start_column + length > OLED_DISPLAY_WIDTH) ? OLED_DISPLAY_WIDTH - 1 : start_column + length - 1;
+    cmd_array[5] = start_page + (start_column + length - 1) / OLED_DISPLAY_WIDTH;
 #endif
 }
 
@@ -281,75 +283,140 @@ uint8_t crot(uint8_t a, int8_t n) {
     return a << n | a >> (-n & mask);
 }
 
+// Spreads the bits of a nibble to bit 0 of one byte each
+static const uint32_t transpose_lut[16] = {
+    0x00000000, 0x00000001, 0x00000100, 0x00000101, 0x00010000, 0x00010001, 0x00010100, 0x00010101,
+    0x01000000, 0x01000001, 0x01000100, 0x01000101, 0x01010000, 0x01010001, 0x01010100, 0x01010101,
+};
+
+// Transposes an 8x8 bit tile: bit i of src[j] becomes bit 7 - j of dest[i]
 static void rotate_90(const uint8_t *src, uint8_t *dest) {
-    for (uint8_t i = 0, shift = 7; i < 8; ++i, --shift) {
-        uint8_t selector = (1 << i);
-        for (uint8_t j = 0; j < 8; ++j) {
-            dest[i] |= crot(src[j] & selector, shift - (int8_t)j);
-        }
+    uint32_t low = 0, high = 0;
+    for (uint8_t j = 0; j < 8; ++j) {
+        low |= transpose_lut[src[j] & 0x0F] << (7 - j);
+        high |= transpose_lut[src[j] >> 4] << (7 - j);
+    }
+    for (uint8_t i = 0; i < 4; ++i) {
+        dest[i] |= low >> (i * 8);
+        dest[i + 4] |= high >> (i * 8);
     }
 }
 
-void oled_render(void) {
-    if (!oled_initialized) {
-        return;
+// Sends one addressing window of the buffer
+static bool render_window(uint16_t start, uint16_t length) {
+    static uint8_t display_start[] = {I2C_CMD, COLUMN_ADDR, 0, OLED_DISPLAY_WIDTH - 1, PAGE_ADDR, 0, OLED_DISPLAY_HEIGHT / 8 - 1};
+    calc_bounds(start, length, &display_start[1]); // Offset from I2C_CMD byte at the start
+
+    // Send column & page position
+    if (I2C_TRANSMIT(display_start) != I2C_STATUS_SUCCESS) {
+        print("oled_render offset command failed\n");
+        return false;
     }
 
-    // Do we have work to do?
-    oled_dirty &= OLED_ALL_BLOCKS_MASK;
-    if (!oled_dirty || oled_scrolling) {
-        return;
+    // Send render data chunk as is
+    if (I2C_WRITE_REG(I2C_DATA, &oled_buffer[start], length) != I2C_STATUS_SUCCESS) {
+        print("oled_render data failed\n");
+        return false;
     }
+    return true;
+}
 
-    // Find first dirty block
-    uint8_t update_start = 0;
-    while (!(oled_dirty & ((OLED_BLOCK_TYPE)1 << update_start))) {
-        ++update_start;
+// Sends a run of adjacent blocks with as few windows as the addressing mode allows
+static bool render_run(uint16_t start, uint16_t length) {
+    while (length) {
+        uint16_t window = OLED_DISPLAY_WIDTH - start % OLED_DISPLAY_WIDTH;
+#if (OLED_IC != OLED_IC_SH1106)
+        // horizontal addressing wraps to the next page, but only back to the first column of the window
+        if (start % OLED_DISPLAY_WIDTH == 0) {
+            window = length;
+        }
+#endif
+        if (window > length) {
+            window = length;
+        }
+        if (!render_window(start, window)) {
+            return false;
+        }
+        start += window;
+        length -= window;
     }
+    return true;
+}
 
+static bool render_block_90(uint8_t update_start) {
     // Set column & page position
     static uint8_t display_start[] = {I2C_CMD, COLUMN_ADDR, 0, OLED_DISPLAY_WIDTH - 1, PAGE_ADDR, 0, OLED_DISPLAY_HEIGHT / 8 - 1};
-    if (!HAS_FLAGS(oled_rotation, OLED_ROTATION_90)) {
-        calc_bounds(update_start, &display_start[1]); // Offset from I2C_CMD byte at the start
-    } else {
-        calc_bounds_90(update_start, &display_start[1]); // Offset from I2C_CMD byte at the start
-    }
+    calc_bounds_90(update_start, &display_start[1]); // Offset from I2C_CMD byte at the start
 
     // Send column & page position
     if (I2C_TRANSMIT(display_start) != I2C_STATUS_SUCCESS) {
         print("oled_render offset command failed\n");
+        return false;
+    }
+
+    // Rotate the render chunks
+    const static uint8_t source_map[] = OLED_SOURCE_MAP;
+    const static uint8_t target_map[] = OLED_TARGET_MAP;
+
+    static uint8_t temp_buffer[OLED_BLOCK_SIZE];
+    memset(temp_buffer, 0, sizeof(temp_buffer));
+    for (uint8_t i = 0; i < sizeof(source_map); ++i) {
+        rotate_90(&oled_buffer[OLED_BLOCK_SIZE * update_start + source_map[i]], &temp_buffer[target_map[i]]);
+    }
+
+    // Send render data chunk after rotating
+    if (I2C_WRITE_REG(I2C_DATA, &temp_buffer[0], OLED_BLOCK_SIZE) != I2C_STATUS_SUCCESS) {
+        print("oled_render90 data failed\n");
+        return false;
+    }
+    return true;
+}
+
+void oled_render(void) {
+    if (!oled_initialized) {
         return;
     }
 
-    if (!HAS_FLAGS(oled_rotation, OLED_ROTATION_90)) {
-        // Send render data chunk as is
-        if (I2C_WRITE_REG(I2C_DATA, &oled_buffer[OLED_BLOCK_SIZE * update_start], OLED_BLOCK_SIZE) != I2C_STATUS_SUCCESS) {
-            print("oled_render data failed\n");
-            return;
+    // Do we have work to do?
+    oled_dirty &= OLED_ALL_BLOCKS_MASK;
+    if (!oled_dirty || oled_scrolling) {
+        return;
+    }
+
+    uint16_t budget       = OLED_RENDER_CHUNK_SIZE;
+    uint8_t  update_start = 0;
+    bool     rendered     = false;
+    do {
+        // Find next dirty block
+        while (!(oled_dirty & ((OLED_BLOCK_TYPE)1 << update_start))) {
+            ++update_start;
         }
-    } else {
-        // Rotate the render chunks
-        const static uint8_t source_map[] = OLED_SOURCE_MAP;
-        const static uint8_t target_map[] = OLED_TARGET_MAP;
-
-        static uint8_t temp_buffer[OLED_BLOCK_SIZE];
-        memset(temp_buffer, 0, sizeof(temp_buffer));
-        for (uint8_t i = 0; i < sizeof(source_map); ++i) {
-            rotate_90(&oled_buffer[OLED_BLOCK_SIZE * update_start + source_map[i]], &temp_buffer[target_map[i]]);
+
+        // Merge the following dirty blocks into the same run, as far as the budget allows
+        uint8_t count = 1;
+        if (!HAS_FLAGS(oled_rotation, OLED_ROTATION_90)) {
+            while (update_start + count < OLED_BLOCK_COUNT && (oled_dirty & ((OLED_BLOCK_TYPE)1 << (update_start + count))) && (uint16_t)(count + 1) * OLED_BLOCK_SIZE <= budget) {
+                ++count;
+            }
+            if (!render_run(OLED_BLOCK_SIZE * update_start, OLED_BLOCK_SIZE * count)) {
+                break;
+            }
+        } else if (!render_block_90(update_start)) {
+            break;
         }
+        rendered = true;
 
-        // Send render data chunk after rotating
-        if (I2C_WRITE_REG(I2C_DATA, &temp_buffer[0], OLED_BLOCK_SIZE) != I2C_STATUS_SUCCESS) {
-            print("oled_render90 data failed\n");
-            return;
+        // Clear dirty flags
+        for (uint8_t i = 0; i < count; ++i, ++update_start) {
+            oled_dirty &= ~((OLED_BLOCK_TYPE)1 << update_start);
         }
-    }
+        budget = (uint16_t)count * OLED_BLOCK_SIZE < budget ? budget - count * OLED_BLOCK_SIZE : 0;
+    } while (oled_dirty && budget >= OLED_BLOCK_SIZE);
 
     // Turn on display if it is off
-    oled_on();
-
-    // Clear dirty flag
-    oled_dirty &= ~((OLED_BLOCK_TYPE)1 << update_start);
+    if (rendered) {
+        oled_on();
+    }
 }
 
 void oled_set_cursor(uint8_t col, uint8_t line) {
@@ -77,6 +77,7 @@ POSSIBILITY OF SUCH DAMAGE.
 #define PS2_ERR_STARTBIT3 3
 #define PS2_ERR_PARITY 0x10
 #define PS2_ERR_NODATA 0x20
+#define PS2_ERR_OVERRUN 0x40
 
 #define PS2_LED_SCROLL_LOCK 0
 #define PS2_LED_NUM_LOCK 1
@@ -90,6 +91,11 @@ uint8_t ps2_host_recv_response(void);
 uint8_t ps2_host_recv(void);
 void    ps2_host_set_led(uint8_t usb_led);
 
+#ifdef PS2_USE_DMA
+/* number of received bytes waiting, lets callers take whole packets at once */
+uint8_t ps2_host_recv_available(void);
+#endif
+
 /*--------------------------------------------------------------------
  * static functions
  *------------------------------------------------------------------*/
@@ -52,6 +52,7 @@ POSSIBILITY OF SUCH DAMAGE.
 #include "ps2.h"
 #include "ps2_io.h"
 #include "print.h"
+#include "spsc_queue.h"
 #include "wait.h"
 
 #define WAIT(stat, us, err)     \
@@ -261,84 +262,18 @@ void ps2_host_set_led(uint8_t led) {
  * Ring buffer to store scan codes from keyboard
  *------------------------------------------------------------------*/
 #define PBUF_SIZE 32
-static uint8_t     pbuf[PBUF_SIZE];
-static uint8_t     pbuf_head = 0;
-static uint8_t     pbuf_tail = 0;
-static inline void pbuf_enqueue(uint8_t data) {
-#if defined(__AVR__)
-    uint8_t sreg = SREG;
-    cli();
-#elif defined(PROTOCOL_CHIBIOS)
-    chSysLockFromISR();
-#endif
+SPSC_QUEUE(pbuf, uint8_t, PBUF_SIZE);
 
-    uint8_t next = (pbuf_head + 1) % PBUF_SIZE;
-    if (next != pbuf_tail) {
-        pbuf[pbuf_head] = data;
-        pbuf_head       = next;
-    } else {
+static inline void pbuf_enqueue(uint8_t data) {
+    if (!pbuf_push(data)) {
         print("pbuf: full\n");
     }
-
-#if defined(__AVR__)
-    SREG = sreg;
-#elif defined(PROTOCOL_CHIBIOS)
-    chSysUnlockFromISR();
-#endif
 }
 static inline uint8_t pbuf_dequeue(void) {
     uint8_t val = 0;
-
-#if defined(__AVR__)
-    uint8_t sreg = SREG;
-    cli();
-#elif defined(PROTOCOL_CHIBIOS)
-    chSysLock();
-#endif
-
-    if (pbuf_head != pbuf_tail) {
-        val       = pbuf[pbuf_tail];
-        pbuf_tail = (pbuf_tail + 1) % PBUF_SIZE;
-    }
-
-#if defined(__AVR__)
-    SREG = sreg;
-#elif defined(PROTOCOL_CHIBIOS)
-    chSysUnlock();
-#endif
-
+    pbuf_pop(&val);
     return val;
 }
 static inline bool pbuf_has_data(void) {
-#if defined(__AVR__)
-    uint8_t sreg = SREG;
-    cli();
-#elif defined(PROTOCOL_CHIBIOS)
-    chSysLock();
-#endif
-
-    bool has_data = (pbuf_head != pbuf_tail);
-
-#if defined(__AVR__)
-    SREG = sreg;
-#elif defined(PROTOCOL_CHIBIOS)
-    chSysUnlock();
-#endif
-    return has_data;
-}
-static inline void pbuf_clear(void) {
-#if defined(__AVR__)
-    uint8_t sreg = SREG;
-    cli();
-#elif defined(PROTOCOL_CHIBIOS)
-    chSysLock();
-#endif
-
-    pbuf_head = pbuf_tail = 0;
-
-#if defined(__AVR__)
-    SREG = sreg;
-#elif defined(PROTOCOL_CHIBIOS)
-    chSysUnlock();
-#endif
+    return !pbuf_empty();
 }
@@ -75,19 +75,38 @@ void ps2_mouse_task(void) {
     extern int     tp_buttons;
 
     /* receives packet from mouse */
+#if defined(PS2_USE_DMA) && !defined(PS2_MOUSE_USE_REMOTE_MODE)
+    /* the driver buffers what the mouse streams, so only whole packets are taken */
+    if (ps2_host_recv_available() < PS2_MOUSE_PACKET_SIZE) {
+        return;
+    }
+    mouse_report.buttons = ps2_host_recv();
+    if (!(mouse_report.buttons & (1 << 3))) {
+        // out of step, bit 3 of the first byte is always set
+        if (debug_mouse) print("ps2_mouse: skipping byte to resync\n");
+        return;
+    }
+    mouse_report.buttons |= tp_buttons;
+    mouse_report.x = ps2_host_recv() * PS2_MOUSE_X_MULTIPLIER;
+    mouse_report.y = ps2_host_recv() * PS2_MOUSE_Y_MULTIPLIER;
+#    ifdef PS2_MOUSE_ENABLE_SCROLLING
+    mouse_report.v = -(ps2_host_recv() & PS2_MOUSE_SCROLL_MASK) * PS2_MOUSE_V_MULTIPLIER;
+#    endif
+#else
     uint8_t rcv;
     rcv = ps2_host_send(PS2_MOUSE_READ_DATA);
     if (rcv == PS2_ACK) {
         mouse_report.buttons = ps2_host_recv_response() | tp_buttons;
         mouse_report.x       = ps2_host_recv_response() * PS2_MOUSE_X_MULTIPLIER;
         mouse_report.y       = ps2_host_recv_response() * PS2_MOUSE_Y_MULTIPLIER;
-#ifdef PS2_MOUSE_ENABLE_SCROLLING
+#    ifdef PS2_MOUSE_ENABLE_SCROLLING
         mouse_report.v = -(ps2_host_recv_response() & PS2_MOUSE_SCROLL_MASK) * PS2_MOUSE_V_MULTIPLIER;
-#endif
+#    endif
     } else {
         if (debug_mouse) print("ps2_mouse: fail to get mouse packet\n");
         return;
     }
+#endif
 
     /* if mouse moves or buttons state changes */
     if (mouse_report.x || mouse_report.y || mouse_report.v || ((mouse_report.buttons ^ buttons_prev) & PS2_MOUSE_BTN_MASK)) {
@@ -113,6 +113,14 @@ __attribute__((unused)) static enum ps2_mouse_mode_e {
 #ifndef PS2_MOUSE_SCROLL_MASK
 #    define PS2_MOUSE_SCROLL_MASK 0xFF
 #endif
+/* Bytes per stream mode packet, the scroll wheel adds a fourth */
+#ifndef PS2_MOUSE_PACKET_SIZE
+#    ifdef PS2_MOUSE_ENABLE_SCROLLING
+#        define PS2_MOUSE_PACKET_SIZE 4
+#    else
+#        define PS2_MOUSE_PACKET_SIZE 3
+#    endif
+#endif
 #ifndef PS2_MOUSE_INIT_DELAY
 #    define PS2_MOUSE_INIT_DELAY 1000
 #endif
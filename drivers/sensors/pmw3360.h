@@ -48,6 +48,11 @@
 #    define PMW3360_LIFTOFF_DISTANCE 0x02
 #endif
 
+// firmware bytes sent per pmw3360_init_task() call, about 20us each
+#ifndef PMW3360_FIRMWARE_UPLOAD_CHUNK
+#    define PMW3360_FIRMWARE_UPLOAD_CHUNK 64
+#endif
+
 #ifndef ROTATIONAL_TRANSFORM_ANGLE
 #    define ROTATIONAL_TRANSFORM_ANGLE 0x00
 #endif
@@ -67,6 +72,9 @@ typedef struct {
 } report_pmw3360_t;
 
 bool     pmw3360_init(void);
+void     pmw3360_init_start(void);
+bool     pmw3360_init_task(void);
+bool     pmw3360_ready(void);
 void     pmw3360_upload_firmware(void);
 bool     pmw3360_check_signature(void);
 uint16_t pmw3360_get_cpi(void);
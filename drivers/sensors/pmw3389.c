@@ -21,6 +21,7 @@
 #include "wait.h"
 #include "debug.h"
 #include "print.h"
+#include "timer.h"
 #include "pmw3389_firmware.h"
 
 // Registers
@@ -140,88 +141,191 @@ uint8_t pmw3389_read(uint8_t reg_addr) {
     return data;
 }
 
-bool pmw3389_init(void) {
-    setPinOutput(PMW3389_CS_PIN);
+/* Sensor start up, run as a state machine so that it can continue in the
+ * background while the keyboard is already in use. Each state waits for the
+ * delay the previous one asked for before doing its part.
+ */
+typedef enum {
+    PMW3389_INIT_IDLE,
+    PMW3389_INIT_RESET,
+    PMW3389_INIT_SROM_ENABLE,
+    PMW3389_INIT_SROM_START,
+    PMW3389_INIT_SROM_BURST,
+    PMW3389_INIT_CONFIGURE,
+    PMW3389_INIT_DONE,
+} pmw3389_init_state_t;
+
+static pmw3389_init_state_t init_state   = PMW3389_INIT_IDLE;
+static uint16_t             init_timer   = 0;
+static uint16_t             init_delay   = 0;
+static uint16_t             srom_pos     = 0;
+static uint16_t             init_cpi     = PMW3389_CPI;
+static bool                 init_success = false;
+
+static void pmw3389_init_wait(pmw3389_init_state_t next, uint16_t delay_ms) {
+    init_state = next;
+    init_delay = delay_ms;
+    init_timer = timer_read();
+}
 
-    spi_init();
-    _inBurst = false;
+static void pmw3389_srom_start(void) {
+    pmw3389_write(REG_SROM_Enable, 0x18);
 
-    spi_stop();
     pmw3389_spi_start();
-    spi_stop();
+    spi_write(REG_SROM_Load_Burst | 0x80);
+    wait_us(15);
+    srom_pos = 0;
+}
 
-    pmw3389_write(REG_Shutdown, 0xb6); // Shutdown first
-    wait_ms(300);
+/* Sends up to count bytes of the SROM burst, NCS stays low in between calls.
+ * Returns true once the whole firmware has been sent.
+ */
+static bool pmw3389_srom_send(uint16_t count) {
+    while (count-- && srom_pos < FIRMWARE_LENGTH) {
+        spi_write(pgm_read_byte(firmware_data + srom_pos++));
+#ifndef PMW3389_FIRMWARE_UPLOAD_FAST
+        wait_us(15);
+#endif
+    }
+    return srom_pos >= FIRMWARE_LENGTH;
+}
 
-    pmw3389_spi_start();
-    wait_us(40);
+static void pmw3389_srom_end(void) {
+    wait_us(200);
+    // NCS high ends the burst
     spi_stop();
-    wait_us(40);
-
-    // power up, need to first drive NCS high then low, see above.
-    pmw3389_write(REG_Power_Up_Reset, 0x5a);
-    wait_ms(50);
 
-    // read registers and discard
-    pmw3389_read(REG_Motion);
-    pmw3389_read(REG_Delta_X_L);
-    pmw3389_read(REG_Delta_X_H);
-    pmw3389_read(REG_Delta_Y_L);
-    pmw3389_read(REG_Delta_Y_H);
+    pmw3389_read(REG_SROM_ID);
+    pmw3389_write(REG_Config2, 0x00);
+}
 
-    pmw3389_upload_firmware();
+/* Runs the current state if its delay has passed, sending at most srom_chunk
+ * firmware bytes. Returns true once the sensor is ready.
+ */
+static bool pmw3389_init_step(uint16_t srom_chunk) {
+    if (init_state == PMW3389_INIT_DONE) {
+        return true;
+    }
+    if (init_state == PMW3389_INIT_IDLE || timer_elapsed(init_timer) <= init_delay) {
+        return false;
+    }
 
-    spi_stop();
+    switch (init_state) {
+        case PMW3389_INIT_RESET:
+            pmw3389_spi_start();
+            wait_us(40);
+            spi_stop();
+            wait_us(40);
+
+            // power up, need to first drive NCS high then low, see above.
+            pmw3389_write(REG_Power_Up_Reset, 0x5a);
+            pmw3389_init_wait(PMW3389_INIT_SROM_ENABLE, 50);
+            break;
+        case PMW3389_INIT_SROM_ENABLE:
+            // read registers and discard
+            pmw3389_read(REG_Motion);
+            pmw3389_read(REG_Delta_X_L);
+            pmw3389_read(REG_Delta_X_H);
+            pmw3389_read(REG_Delta_Y_L);
+            pmw3389_read(REG_Delta_Y_H);
+
+            // Datasheet claims we need to disable REST mode first, but during startup
+            // it's already disabled and we're not turning it on ...
+            // pmw3389_write(REG_Config2, 0x00);  // disable REST mode
+            pmw3389_write(REG_SROM_Enable, 0x1d);
+            pmw3389_init_wait(PMW3389_INIT_SROM_START, 10);
+            break;
+        case PMW3389_INIT_SROM_START:
+            pmw3389_srom_start();
+            init_state = PMW3389_INIT_SROM_BURST;
+            // fall through
+        case PMW3389_INIT_SROM_BURST:
+            if (pmw3389_srom_send(srom_chunk)) {
+                pmw3389_srom_end();
+                pmw3389_init_wait(PMW3389_INIT_CONFIGURE, 10);
+            }
+            break;
+        case PMW3389_INIT_CONFIGURE:
+            init_state = PMW3389_INIT_DONE;
+            pmw3389_set_cpi(init_cpi);
+
+            wait_ms(1);
+
+            pmw3389_write(REG_Config2, 0x00);
+
+            pmw3389_write(REG_Angle_Tune, constrain(ROTATIONAL_TRANSFORM_ANGLE, -127, 127));
+
+            pmw3389_write(REG_Lift_Config, PMW3389_LIFTOFF_DISTANCE);
+
+            init_success = pmw3389_check_signature();
+#ifdef CONSOLE_ENABLE
+            if (init_success) {
+                dprintf("pmw3389 signature verified");
+            } else {
+                dprintf("pmw3389 signature verification failed!");
+            }
+#endif
 
-    wait_ms(10);
-    pmw3389_set_cpi(PMW3389_CPI);
+            writePinLow(PMW3389_CS_PIN);
+            return true;
+        default:
+            break;
+    }
+    return false;
+}
 
-    wait_ms(1);
+/** \brief Starts the sensor initialisation
+ *
+ * Resets the sensor and returns, pmw3389_init_task() completes the start up
+ * and the firmware upload. Until pmw3389_ready() motion reads return an empty
+ * report and a CPI set in the meantime is applied at the end.
+ */
+void pmw3389_init_start(void) {
+    setPinOutput(PMW3389_CS_PIN);
 
-    pmw3389_write(REG_Config2, 0x00);
+    spi_init();
+    _inBurst = false;
 
-    pmw3389_write(REG_Angle_Tune, constrain(ROTATIONAL_TRANSFORM_ANGLE, -127, 127));
+    spi_stop();
+    pmw3389_spi_start();
+    spi_stop();
 
-    pmw3389_write(REG_Lift_Config, PMW3389_LIFTOFF_DISTANCE);
+    init_success = false;
+    init_state   = PMW3389_INIT_IDLE;
+    pmw3389_write(REG_Shutdown, 0xb6); // Shutdown first
+    pmw3389_init_wait(PMW3389_INIT_RESET, 300);
+}
 
-    bool init_success = pmw3389_check_signature();
-#ifdef CONSOLE_ENABLE
-    if (init_success) {
-        dprintf("pmw3389 signature verified");
-    } else {
-        dprintf("pmw3389 signature verification failed!");
-    }
-#endif
+/** \brief Advances the sensor initialisation
+ *
+ * Never waits for the start up delays, and sends the firmware in
+ * PMW3389_FIRMWARE_UPLOAD_CHUNK byte pieces. Note that the SPI bus stays
+ * selected between the pieces of the upload, so other devices on it have to
+ * wait until the sensor is ready. Returns true once the sensor is ready.
+ */
+bool pmw3389_init_task(void) {
+    return pmw3389_init_step(PMW3389_FIRMWARE_UPLOAD_CHUNK);
+}
 
-    writePinLow(PMW3389_CS_PIN);
+bool pmw3389_ready(void) {
+    return init_state == PMW3389_INIT_DONE;
+}
 
+bool pmw3389_init(void) {
+    pmw3389_init_start();
+    while (!pmw3389_init_step(FIRMWARE_LENGTH)) {
+    }
     return init_success;
 }
 
 void pmw3389_upload_firmware(void) {
-    // Datasheet claims we need to disable REST mode first, but during startup
-    // it's already disabled and we're not turning it on ...
-    // pmw3389_write(REG_Config2, 0x00);  // disable REST mode
     pmw3389_write(REG_SROM_Enable, 0x1d);
 
     wait_ms(10);
 
-    pmw3389_write(REG_SROM_Enable, 0x18);
-
-    pmw3389_spi_start();
-    spi_write(REG_SROM_Load_Burst | 0x80);
-    wait_us(15);
-
-    for (uint16_t i = 0; i < FIRMWARE_LENGTH; i++) {
-        spi_write(pgm_read_byte(firmware_data + i));
-#ifndef PMW3389_FIRMWARE_UPLOAD_FAST
-        wait_us(15);
-#endif
-    }
-    wait_us(200);
-
-    pmw3389_read(REG_SROM_ID);
-    pmw3389_write(REG_Config2, 0x00);
+    pmw3389_srom_start();
+    pmw3389_srom_send(FIRMWARE_LENGTH);
+    pmw3389_srom_end();
 }
 
 bool pmw3389_check_signature(void) {
@@ -232,11 +336,19 @@ bool pmw3389_check_signature(void) {
 }
 
 uint16_t pmw3389_get_cpi(void) {
+    if (!pmw3389_ready()) {
+        return init_cpi;
+    }
     uint16_t cpival = (pmw3389_read(REG_Resolution_H) << 8) | pmw3389_read(REG_Resolution_L);
     return (uint16_t)((cpival + 1) & 0xffff) * CPI_STEP;
 }
 
 void pmw3389_set_cpi(uint16_t cpi) {
+    if (!pmw3389_ready()) {
+        init_cpi = cpi;
+        return;
+    }
+
     uint16_t cpival = constrain((cpi / CPI_STEP) - 1, 0, MAX_CPI);
     // Sets upper byte first for more consistent setting of cpi
     pmw3389_write(REG_Resolution_H, (cpival >> 8) & 0xff);
@@ -246,6 +358,10 @@ void pmw3389_set_cpi(uint16_t cpi) {
 report_pmw3389_t pmw3389_read_burst(void) {
     report_pmw3389_t report = {0};
 
+    if (!pmw3389_init_task()) {
+        return report;
+    }
+
     if (!_inBurst) {
 #ifdef CONSOLE_ENABLE
         dprintf("burst on");
@@ -49,6 +49,11 @@
 #    define PMW3389_LIFTOFF_DISTANCE 0x02
 #endif
 
+// firmware bytes sent per pmw3389_init_task() call, about 20us each
+#ifndef PMW3389_FIRMWARE_UPLOAD_CHUNK
+#    define PMW3389_FIRMWARE_UPLOAD_CHUNK 64
+#endif
+
 #ifndef ROTATIONAL_TRANSFORM_ANGLE
 #    define ROTATIONAL_TRANSFORM_ANGLE 0x00
 #endif
@@ -68,6 +73,9 @@ typedef struct {
 } report_pmw3389_t;
 
 bool     pmw3389_init(void);
+void     pmw3389_init_start(void);
+bool     pmw3389_init_task(void);
+bool     pmw3389_ready(void);
 void     pmw3389_upload_firmware(void);
 bool     pmw3389_check_signature(void);
 uint16_t pmw3389_get_cpi(void);
@@ -203,12 +203,12 @@ const uint16_t PROGMEM keymaps[][MATRIX_ROWS][MATRIX_COLS] = {
 // Runs just one time when the keyboard initializes.
 void matrix_init_user(void) {
     // If our magic word wasn't set properly, we need to zero out the settings.
-    if (eeprom_read_word(EECONFIG_BELAK) != EECONFIG_BELAK_MAGIC) {
-        eeprom_update_word(EECONFIG_BELAK, EECONFIG_BELAK_MAGIC);
-        eeprom_update_byte(EECONFIG_BELAK_SWAP_GUI_CTRL, 0);
+    if (eeconfig_read_word(EECONFIG_BELAK) != EECONFIG_BELAK_MAGIC) {
+        eeconfig_update_word(EECONFIG_BELAK, EECONFIG_BELAK_MAGIC);
+        eeconfig_update_byte(EECONFIG_BELAK_SWAP_GUI_CTRL, 0);
     }
 
-    if (eeprom_read_byte(EECONFIG_BELAK_SWAP_GUI_CTRL)) {
+    if (eeconfig_read_byte(EECONFIG_BELAK_SWAP_GUI_CTRL)) {
         layer_on(SWPH);
         swap_gui_ctrl = 1;
     }
@@ -246,7 +246,7 @@ bool process_record_user(uint16_t keycode, keyrecord_t *record) {
     case BEL_F0:
         if(record->event.pressed){
             swap_gui_ctrl = !swap_gui_ctrl;
-            eeprom_update_byte(EECONFIG_BELAK_SWAP_GUI_CTRL, swap_gui_ctrl);
+            eeconfig_update_byte(EECONFIG_BELAK_SWAP_GUI_CTRL, swap_gui_ctrl);
 
             if (swap_gui_ctrl) {
                 layer_on(SWPH);
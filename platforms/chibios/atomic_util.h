@@ -30,8 +30,20 @@ static __inline__ void __interrupt_enable__(const uint8_t *__s) {
     (void)__s;
 }
 
+static __inline__ syssts_t __interrupt_save__(void) {
+    return chSysGetStatusAndLockX();
+}
+
+static __inline__ void __interrupt_restore__(const syssts_t *__s) {
+    chSysRestoreStatusX(*__s);
+
+    __asm__ volatile("" ::: "memory");
+}
+
 #define ATOMIC_BLOCK(type) for (type, __ToDo = __interrupt_disable__(); __ToDo; __ToDo = 0)
 #define ATOMIC_FORCEON uint8_t sreg_save __attribute__((__cleanup__(__interrupt_enable__))) = 0
+#define ATOMIC_RESTORESTATE syssts_t sts_save __attribute__((__cleanup__(__interrupt_restore__))) = __interrupt_save__()
 
-#define ATOMIC_BLOCK_RESTORESTATE _Static_assert(0, "ATOMIC_BLOCK_RESTORESTATE not implemented")
+// usable from any context, including interrupt handlers
+#define ATOMIC_BLOCK_RESTORESTATE for (ATOMIC_RESTORESTATE, __ToDo = 1; __ToDo; __ToDo = 0)
 #define ATOMIC_BLOCK_FORCEON ATOMIC_BLOCK(ATOMIC_FORCEON)
@@ -16,6 +16,7 @@
  */
 
 #include "audio.h"
+#include <string.h>
 #include <ch.h>
 #include <hal.h>
 
@@ -79,13 +80,52 @@ static const dacsample_t dac_buffer_trapezoid[AUDIO_DAC_BUFFER_SIZE] = {0x0,   0
                                                                         0xfff, 0xfdf, 0xf7f, 0xf1f, 0xebf, 0xe5f, 0xdff, 0xd9f, 0xd3f, 0xcdf, 0xc7f, 0xc1f, 0xbbf, 0xb5f, 0xaff, 0xa9f, 0xa3f, 0x9df, 0x97f, 0x91f, 0x8bf, 0x85f, 0x7ff, 0x79f, 0x73f, 0x6df, 0x67f, 0x61f, 0x5bf, 0x55f, 0x4ff, 0x49f, 0x43f, 0x3df, 0x37f, 0x31f, 0x2bf, 0x25f, 0x1ff, 0x19f, 0x13f, 0xdf,  0x7f,  0x1f,  0x0,   0x0,   0x0,   0x0,   0x0,   0x0,   0x0,   0x0,   0x0,   0x0,   0x0,   0x0,   0x0,   0x0,   0x0,   0x0,   0x0,   0x0,   0x0,   0x0,   0x0,   0x0,   0x0,   0x0,   0x0,   0x0,   0x0,   0x0,   0x0,   0x0,   0x0,   0x0,   0x0,   0x0,   0x0,   0x0,   0x0,   0x0,   0x0,   0x0,   0x0,   0x0,   0x0,   0x0,   0x0,   0x0,   0x0,   0x0,   0x0,   0x0,   0x0,   0x0,   0x0,   0x0,   0x0,   0x0,   0x0,   0x0,   0x0,   0x0,   0x0,   0x0,   0x0,   0x0,   0x0,   0x0,   0x0,   0x0,   0x0,   0x0,   0x0,   0x0,   0x0,   0x0,   0x0,   0x0,   0x0,   0x0,   0x0,   0x0,   0x0,   0x0,   0x0,   0x0};
 #endif // AUDIO_DAC_SAMPLE_WAVEFORM_TRAPEZOID
 
+#if defined(AUDIO_DAC_SAMPLE_WAVEFORM_SINE)
+#    define DAC_WAVETABLE dac_buffer_sine
+#elif defined(AUDIO_DAC_SAMPLE_WAVEFORM_TRIANGLE)
+#    define DAC_WAVETABLE dac_buffer_triangle
+#elif defined(AUDIO_DAC_SAMPLE_WAVEFORM_TRAPEZOID)
+#    define DAC_WAVETABLE dac_buffer_trapezoid
+#elif defined(AUDIO_DAC_SAMPLE_WAVEFORM_SQUARE)
+#    define DAC_WAVETABLE dac_buffer_square
+#endif
+
+#if (AUDIO_DAC_BUFFER_SIZE & (AUDIO_DAC_BUFFER_SIZE - 1)) != 0
+#    error "AUDIO_DAC_BUFFER_SIZE has to be a power of two"
+#endif
+
 static dacsample_t dac_buffer_empty[AUDIO_DAC_BUFFER_SIZE] = {AUDIO_DAC_OFF_VALUE};
 
-/* keep track of the sample position for for each frequency */
-static float dac_if[AUDIO_MAX_SIMULTANEOUS_TONES] = {0.0};
+/* keep track of the sample position for each frequency, as Q16.16 index into the wavetable,
+ * and how far it advances per sample */
+static uint32_t dac_phase[AUDIO_MAX_SIMULTANEOUS_TONES]           = {0};
+static uint32_t dac_phase_increment[AUDIO_MAX_SIMULTANEOUS_TONES] = {0};
 
-static float   active_tones_snapshot[AUDIO_MAX_SIMULTANEOUS_TONES] = {0, 0};
-static uint8_t active_tones_snapshot_length                        = 0;
+static uint8_t  active_tones_snapshot_length = 0;
+static uint32_t active_tones_mix_scale       = 0; // Q16.16 reciprocal of active_tones_snapshot_length
+
+/**
+ * Converts the currently playing tones, with the voice effects applied, into phase
+ * increments. Rest notes are left out. Returns the number of increments written.
+ *
+ * This does the float math once per tone and buffer half, instead of for every sample.
+ */
+static uint8_t dac_sample_tones(uint32_t increments[AUDIO_MAX_SIMULTANEOUS_TONES]) {
+    uint8_t active_tones = MIN(AUDIO_MAX_SIMULTANEOUS_TONES, audio_get_number_of_active_tones());
+    uint8_t count        = 0;
+
+    for (uint8_t i = 0; i < active_tones; i++) {
+        float freq = audio_get_processed_frequency(i);
+        if (freq > 0) { // disregard 'rest' notes, with valid frequency 0.0f; which would only lower the resulting waveform volume during the additive synthesis step
+            /*Note: the 2/3 are necessary to get the correct frequencies on the
+             *      DAC output (as measured with an oscilloscope), since the gpt
+             *      timer runs with 3*AUDIO_DAC_SAMPLE_RATE; and the DAC callback
+             *      is called twice per conversion.*/
+            increments[count++] = (uint32_t)(freq * AUDIO_DAC_BUFFER_SIZE * 2 / 3 / AUDIO_DAC_SAMPLE_RATE * 65536.0f);
+        }
+    }
+    return count;
+}
 
 typedef enum {
     OUTPUT_SHOULD_START,
@@ -116,49 +156,21 @@ __attribute__((weak)) uint16_t dac_value_generate(void) {
     /* doing additive wave synthesis over all currently playing tones = adding up
      * sine-wave-samples for each frequency, scaled by the number of active tones
      */
-    uint16_t value     = 0;
-    float    frequency = 0.0f;
+    uint32_t value = 0;
 
     for (uint8_t i = 0; i < active_tones_snapshot_length; i++) {
-        /* Note: a user implementation does not have to rely on the active_tones_snapshot, but
+        /* Note: a user implementation does not have to rely on the phase increments, but
          * could directly query the active frequencies through audio_get_processed_frequency */
-        frequency = active_tones_snapshot[i];
-
-        dac_if[i] = dac_if[i] + ((frequency * AUDIO_DAC_BUFFER_SIZE) / AUDIO_DAC_SAMPLE_RATE) * 2 / 3;
-        /*Note: the 2/3 are necessary to get the correct frequencies on the
-         *      DAC output (as measured with an oscilloscope), since the gpt
-         *      timer runs with 3*AUDIO_DAC_SAMPLE_RATE; and the DAC callback
-         *      is called twice per conversion.*/
+        dac_phase[i] += dac_phase_increment[i];
 
-        dac_if[i] = fmod(dac_if[i], AUDIO_DAC_BUFFER_SIZE);
-
-        // Wavetable generation/lookup
-        uint16_t dac_i = (uint16_t)dac_if[i];
-
-#if defined(AUDIO_DAC_SAMPLE_WAVEFORM_SINE)
-        value += dac_buffer_sine[dac_i] / active_tones_snapshot_length;
-#elif defined(AUDIO_DAC_SAMPLE_WAVEFORM_TRIANGLE)
-        value += dac_buffer_triangle[dac_i] / active_tones_snapshot_length;
-#elif defined(AUDIO_DAC_SAMPLE_WAVEFORM_TRAPEZOID)
-        value += dac_buffer_trapezoid[dac_i] / active_tones_snapshot_length;
-#elif defined(AUDIO_DAC_SAMPLE_WAVEFORM_SQUARE)
-        value += dac_buffer_square[dac_i] / active_tones_snapshot_length;
-#endif
-        /*
-        // SINE
-        value += dac_buffer_sine[dac_i] / active_tones_snapshot_length / 3;
-        // TRIANGLE
-        value += dac_buffer_triangle[dac_i] / active_tones_snapshot_length / 3;
-        // SQUARE
-        value += dac_buffer_square[dac_i] / active_tones_snapshot_length / 3;
-        //NOTE: combination of these three wave-forms is more exemplary - and doesn't sound particularly good :-P
-        */
+        // Wavetable lookup, the integer part of the phase wraps around the table
+        value += DAC_WAVETABLE[(dac_phase[i] >> 16) & (AUDIO_DAC_BUFFER_SIZE - 1)];
 
         // STAIRS (mostly usefully as test-pattern)
-        // value_avg = dac_buffer_staircase[dac_i] / active_tones_snapshot_length;
+        // value += dac_buffer_staircase[(dac_phase[i] >> 16) & (AUDIO_DAC_BUFFER_SIZE - 1)];
     }
 
-    return value;
+    return (value * active_tones_mix_scale) >> 16;
 }
 
 /**
@@ -174,6 +186,15 @@ static void dac_end(DACDriver *dacp) {
         sample_p += AUDIO_DAC_BUFFER_SIZE / 2; // 'half_index'
     }
 
+    // follow frequency changes of the playing tones (vibrato, glissando, ...) once per buffer half;
+    // the phase stays continuous, so unlike a change of the tones this does not need to wait for zero
+    if (OUTPUT_RUN_NORMALLY == state) {
+        uint32_t increments[AUDIO_MAX_SIMULTANEOUS_TONES];
+        if (dac_sample_tones(increments) == active_tones_snapshot_length) {
+            memcpy(dac_phase_increment, increments, sizeof(increments[0]) * active_tones_snapshot_length);
+        }
+    }
+
     for (uint8_t s = 0; s < AUDIO_DAC_BUFFER_SIZE / 2; s++) {
         if (OUTPUT_OFF <= state) {
             sample_p[s] = AUDIO_DAC_OFF_VALUE;
@@ -214,16 +235,10 @@ static void dac_end(DACDriver *dacp) {
         }
 
         if ((OUTPUT_SHOULD_START == state) || (OUTPUT_REACHED_ZERO_BEFORE_OFF == state) || (OUTPUT_REACHED_ZERO_BEFORE_TONE_CHANGE == state)) {
-            uint8_t active_tones         = MIN(AUDIO_MAX_SIMULTANEOUS_TONES, audio_get_number_of_active_tones());
-            active_tones_snapshot_length = 0;
             // update the snapshot - once, and only on occasion that something changed;
-            // -> saves cpu cycles (?)
-            for (uint8_t i = 0; i < active_tones; i++) {
-                float freq = audio_get_processed_frequency(i);
-                if (freq > 0) { // disregard 'rest' notes, with valid frequency 0.0f; which would only lower the resulting waveform volume during the additive synthesis step
-                    active_tones_snapshot[active_tones_snapshot_length++] = freq;
-                }
-            }
+            // -> saves cpu cycles
+            active_tones_snapshot_length = dac_sample_tones(dac_phase_increment);
+            active_tones_mix_scale       = active_tones_snapshot_length ? 65536U / active_tones_snapshot_length : 0;
 
             if ((0 == active_tones_snapshot_length) && (OUTPUT_REACHED_ZERO_BEFORE_OFF == state)) {
                 state = OUTPUT_OFF;
@@ -329,9 +344,10 @@ void audio_driver_start(void) {
     gptStartContinuous(&GPTD6, 2U);
 
     for (uint8_t i = 0; i < AUDIO_MAX_SIMULTANEOUS_TONES; i++) {
-        dac_if[i]                = 0.0f;
-        active_tones_snapshot[i] = 0.0f;
+        dac_phase[i]           = 0;
+        dac_phase_increment[i] = 0;
     }
     active_tones_snapshot_length = 0;
+    active_tones_mix_scale       = 0;
     state                        = OUTPUT_SHOULD_START;
 }
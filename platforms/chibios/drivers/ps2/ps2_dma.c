@@ -0,0 +1,418 @@
+/* Copyright 2022 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * PS/2 protocol timer capture + DMA version
+ *
+ * The clock line drives a timer input channel. Every falling edge raises a
+ * capture DMA request, which copies the input register of the data port into
+ * a circular buffer. Receiving therefore costs a single interrupt per pass
+ * over the buffer, which counts the passes so an overrun can be detected; the
+ * samples are assembled into 11 bit frames whenever a byte is asked for.
+ *
+ * A byte with a framing or parity error is asked for again with PS2_RESEND,
+ * as long as it was the last byte the device sent. Otherwise, and after
+ * PS2_DMA_RESEND_RETRY attempts, it is dropped.
+ *
+ * A keyboard answers PS2_RESEND with its last byte, but a mouse in stream
+ * mode repeats its whole last packet. For the mouse, bytes are therefore only
+ * handed on once their packet is complete, or once the clock goes quiet, and
+ * a frame error drops the rest of its packet, so the repeat is not appended
+ * to the part that was already received.
+ */
+
+#include <stdbool.h>
+#include "ps2.h"
+#include "ps2_io.h"
+#include "print.h"
+#include "spsc_queue.h"
+#include "timer.h"
+#include "wait.h"
+#if defined(PS2_MOUSE_ENABLE) && !defined(PS2_MOUSE_USE_REMOTE_MODE)
+#    include "ps2_mouse.h"
+#    define PS2_DMA_PACKET_SIZE PS2_MOUSE_PACKET_SIZE
+#else
+#    define PS2_DMA_PACKET_SIZE 1
+#endif
+
+// chibiOS headers
+#include "ch.h"
+#include "hal.h"
+
+#if !(defined(PS2_CLOCK_PIN))
+#    error "PS/2 clock setting is required in config.h"
+#endif
+
+#if !(defined(PS2_DATA_PIN))
+#    error "PS/2 data setting is required in config.h"
+#endif
+
+#ifndef PS2_ICU_DRIVER
+#    define PS2_ICU_DRIVER ICUD2
+#endif
+#ifndef PS2_ICU_CHANNEL
+#    define PS2_ICU_CHANNEL 1 // timer channel the clock pin is connected to, 1 or 2
+#endif
+#ifndef PS2_CLOCK_PAL_MODE
+#    define PS2_CLOCK_PAL_MODE 1 // alternate function of the clock pin for the timer channel
+#endif
+#ifndef PS2_DMA_STREAM
+#    error "please consult your MCU's datasheet and specify in your config.h: #define PS2_DMA_STREAM STM32_DMA?_STREAM? (DMA stream for the capture event of PS2_ICU_CHANNEL)"
+#endif
+#ifndef PS2_DMA_CHANNEL
+#    define PS2_DMA_CHANNEL 0 // DMA Channel for TIMx_CHy
+#endif
+#if (STM32_DMA_SUPPORTS_DMAMUX == TRUE) && !defined(PS2_DMAMUX_ID)
+#    error "please consult your MCU's datasheet and specify in your config.h: #define PS2_DMAMUX_ID STM32_DMAMUX1_TIM?_CH?"
+#endif
+
+// Number of clock edges the buffer holds, 11 per byte
+#ifndef PS2_DMA_BUFFER_SIZE
+#    define PS2_DMA_BUFFER_SIZE 256
+#endif
+// A partial frame is dropped after the clock has been quiet this long (ms)
+#ifndef PS2_DMA_FRAME_TIMEOUT
+#    define PS2_DMA_FRAME_TIMEOUT 2
+#endif
+// Number of times a broken byte is asked for again
+#ifndef PS2_DMA_RESEND_RETRY
+#    define PS2_DMA_RESEND_RETRY 3
+#endif
+
+#if PS2_ICU_CHANNEL == 1
+#    define PS2_ICU_CHANNEL_ID ICU_CHANNEL_1
+#    define PS2_ICU_DIER STM32_TIM_DIER_CC1DE
+#elif PS2_ICU_CHANNEL == 2
+#    define PS2_ICU_CHANNEL_ID ICU_CHANNEL_2
+#    define PS2_ICU_DIER STM32_TIM_DIER_CC2DE
+#else
+#    error "PS2_ICU_CHANNEL must be 1 or 2"
+#endif
+
+#define WAIT(stat, us, err)     \
+    do {                        \
+        if (!wait_##stat(us)) { \
+            ps2_error = err;    \
+            goto ERROR;         \
+        }                       \
+    } while (0)
+
+uint8_t ps2_error = PS2_ERR_NONE;
+
+static uint16_t          samples[PS2_DMA_BUFFER_SIZE];
+static volatile uint32_t dma_laps      = 0; // passes over the buffer completed by the DMA
+static uint32_t          sample_count  = 0; // samples decoded since the DMA was started
+static uint16_t          sample_pos    = 0; // next sample to decode
+static uint16_t          frame         = 0; // bits of the current frame, LSB first
+static uint8_t           frame_bits    = 0;
+static bool              frame_skip    = false; // drop bits until the clock goes quiet
+static bool              frame_resend  = false; // ask for the broken frame again once the clock is quiet
+static uint8_t           frame_resends = 0;
+static uint16_t          frame_timer   = 0;
+static uint8_t           packet[PS2_DMA_PACKET_SIZE]; // bytes of a packet that is not complete yet
+static uint8_t           packet_len    = 0;
+
+static bool           ps2_dma_send(uint8_t data);
+static inline uint8_t pbuf_dequeue(void);
+static inline void    pbuf_enqueue(uint8_t data);
+static inline bool    pbuf_has_data(void);
+static inline uint8_t pbuf_size(void);
+static inline void    pbuf_clear(void);
+
+static const ICUConfig icucfg = {
+    .mode      = ICU_INPUT_ACTIVE_LOW, // capture on the falling edge
+    .frequency = 1000000,
+    .channel   = PS2_ICU_CHANNEL_ID,
+    .dier      = PS2_ICU_DIER,
+};
+
+static void ps2_dma_isr(void *param, uint32_t flags) {
+    (void)param;
+    if (flags & STM32_DMA_ISR_TCIF) {
+        dma_laps++;
+    }
+}
+
+static void ps2_dma_start(void) {
+    palSetLineMode(PS2_CLOCK_PIN, PAL_MODE_ALTERNATE(PS2_CLOCK_PAL_MODE));
+    palSetLineMode(PS2_DATA_PIN, PAL_MODE_INPUT);
+
+    dmaStreamSetPeripheral(PS2_DMA_STREAM, &PAL_PORT(PS2_DATA_PIN)->IDR);
+    dmaStreamSetMemory0(PS2_DMA_STREAM, samples);
+    dmaStreamSetTransactionSize(PS2_DMA_STREAM, PS2_DMA_BUFFER_SIZE);
+    dmaStreamSetMode(PS2_DMA_STREAM, STM32_DMA_CR_CHSEL(PS2_DMA_CHANNEL) | STM32_DMA_CR_DIR_P2M | STM32_DMA_CR_PSIZE_HWORD | STM32_DMA_CR_MSIZE_HWORD | STM32_DMA_CR_MINC | STM32_DMA_CR_CIRC | STM32_DMA_CR_TCIE | STM32_DMA_CR_PL(3));
+#if (STM32_DMA_SUPPORTS_DMAMUX == TRUE)
+    dmaSetRequestSource(PS2_DMA_STREAM, PS2_DMAMUX_ID);
+#endif
+
+    dma_laps     = 0;
+    sample_count = 0;
+    sample_pos   = 0;
+    frame_bits   = 0;
+    frame_skip   = false;
+    frame_resend = false;
+    packet_len   = 0; // the device abandons a packet when the host sends
+    dmaStreamEnable(PS2_DMA_STREAM);
+
+    icuStart(&PS2_ICU_DRIVER, &icucfg);
+    icuStartCapture(&PS2_ICU_DRIVER);
+}
+
+static void ps2_dma_stop(void) {
+    icuStopCapture(&PS2_ICU_DRIVER);
+    icuStop(&PS2_ICU_DRIVER);
+    dmaStreamDisable(PS2_DMA_STREAM);
+}
+
+static bool frame_is_valid(uint16_t bits) {
+    // start bit low, stop bit high, odd parity over data and parity bit
+    if ((bits & 0x001) || !(bits & 0x400)) {
+        return false;
+    }
+    uint16_t parity = (bits >> 1) & 0x1FF;
+    parity ^= parity >> 8;
+    parity ^= parity >> 4;
+    parity ^= parity >> 2;
+    parity ^= parity >> 1;
+    return parity & 1;
+}
+
+static void packet_flush(void) {
+    for (uint8_t i = 0; i < packet_len; i++) {
+        pbuf_enqueue(packet[i]);
+    }
+    packet_len = 0;
+}
+
+static void packet_add(uint8_t data) {
+    packet[packet_len++] = data;
+    if (packet_len == PS2_DMA_PACKET_SIZE) {
+        packet_flush();
+    }
+}
+
+/* Number of samples the DMA has written since it was started, modulo 2^32. */
+static uint32_t ps2_dma_written(void) {
+    uint32_t laps;
+    uint16_t remaining;
+    do {
+        laps      = dma_laps;
+        remaining = dmaStreamGetTransactionSize(PS2_DMA_STREAM);
+    } while (laps != dma_laps);
+
+    uint32_t written = laps * PS2_DMA_BUFFER_SIZE + (PS2_DMA_BUFFER_SIZE - remaining);
+    if ((int32_t)(written - sample_count) < 0) {
+        // the counter has already reloaded, but the interrupt has not run yet
+        written += PS2_DMA_BUFFER_SIZE;
+    }
+    return written;
+}
+
+/* Turns the samples captured since the last call into bytes. */
+static void ps2_dma_decode(void) {
+    uint32_t written = ps2_dma_written();
+
+    if (written == sample_count) {
+        // the clock is quiet, a frame can only be complete or lost, and
+        // whatever is left of a packet is a reply to a command
+        if ((frame_bits || frame_skip || packet_len) && timer_elapsed(frame_timer) > PS2_DMA_FRAME_TIMEOUT) {
+            bool resend  = frame_resend;
+            frame_bits   = 0;
+            frame_skip   = false;
+            frame_resend = false;
+            packet_flush();
+            if (resend) {
+                ps2_dma_send(PS2_RESEND);
+            }
+        }
+        return;
+    }
+    frame_timer = timer_read();
+
+    if (written - sample_count > PS2_DMA_BUFFER_SIZE) {
+        // the DMA went round and overwrote samples before they were decoded,
+        // skip to the newest sample and pick up again at the next byte
+        xprintf("PS2 DMA overrun: %lu samples lost\n", written - sample_count - PS2_DMA_BUFFER_SIZE);
+        ps2_error    = PS2_ERR_OVERRUN;
+        sample_count = written;
+        sample_pos   = written % PS2_DMA_BUFFER_SIZE;
+        frame_bits   = 0;
+        frame_skip   = true;
+        frame_resend = false;
+        packet_len   = 0;
+        return;
+    }
+
+    while (sample_count != written) {
+        bool bit   = samples[sample_pos] & PAL_PORT_BIT(PAL_PAD(PS2_DATA_PIN));
+        sample_pos = (sample_pos + 1) % PS2_DMA_BUFFER_SIZE;
+        sample_count++;
+        if (frame_skip) {
+            // the device has moved on, PS2_RESEND would repeat a different byte
+            frame_resend = false;
+            continue;
+        }
+
+        frame = (frame >> 1) | (bit ? 0x400 : 0);
+        if (++frame_bits < 11) {
+            continue;
+        }
+        frame_bits = 0;
+        if (frame_is_valid(frame)) {
+            frame_resends = 0;
+            packet_add((frame >> 1) & 0xFF);
+        } else {
+            ps2_error  = PS2_ERR_PARITY;
+            frame_skip = true;
+            packet_len = 0; // the mouse repeats the whole packet
+            if (frame_resends < PS2_DMA_RESEND_RETRY) {
+                frame_resends++;
+                frame_resend = true;
+            } else {
+                frame_resends = 0;
+            }
+            xprintf("PS2 DMA frame error: %03X\n", frame);
+        }
+    }
+}
+
+void ps2_host_init(void) {
+    idle();
+    dmaStreamAlloc(PS2_DMA_STREAM - STM32_DMA_STREAM(0), 10, ps2_dma_isr, NULL);
+    ps2_dma_start();
+    // POR(150-2000ms) plus BAT(300-500ms) may take 2.5sec([3]p.20)
+    // wait_ms(2500);
+}
+
+/* Sends a byte without waiting for the response. */
+static bool ps2_dma_send(uint8_t data) {
+    bool parity = true;
+    ps2_error   = PS2_ERR_NONE;
+
+    ps2_dma_decode();
+    ps2_dma_stop();
+
+    /* terminate a transmission if we have */
+    inhibit();
+    wait_us(100); // 100us [4]p.13, [5]p.50
+
+    /* 'Request to Send' and Start bit */
+    data_lo();
+    clock_hi();
+    WAIT(clock_lo, 10000, 10); // 10ms [5]p.50
+
+    /* Data bit[2-9] */
+    for (uint8_t i = 0; i < 8; i++) {
+        if (data & (1 << i)) {
+            parity = !parity;
+            data_hi();
+        } else {
+            data_lo();
+        }
+        WAIT(clock_hi, 50, 2);
+        WAIT(clock_lo, 50, 3);
+    }
+
+    /* Parity bit */
+    wait_us(15);
+    if (parity) {
+        data_hi();
+    } else {
+        data_lo();
+    }
+    WAIT(clock_hi, 50, 4);
+    WAIT(clock_lo, 50, 5);
+
+    /* Stop bit */
+    wait_us(15);
+    data_hi();
+
+    /* Ack */
+    WAIT(data_lo, 50, 6);
+    WAIT(clock_lo, 50, 7);
+
+    /* wait for idle state */
+    WAIT(clock_hi, 50, 8);
+    WAIT(data_hi, 50, 9);
+
+    idle();
+    ps2_dma_start();
+    return true;
+ERROR:
+    idle();
+    ps2_dma_start();
+    return false;
+}
+
+uint8_t ps2_host_send(uint8_t data) {
+    if (!ps2_dma_send(data)) {
+        return 0;
+    }
+    return ps2_host_recv_response();
+}
+
+uint8_t ps2_host_recv_response(void) {
+    // Command may take 25ms/20ms at most([5]p.46, [3]p.21)
+    uint8_t retry = 25;
+    ps2_dma_decode();
+    while (retry-- && !pbuf_has_data()) {
+        wait_ms(1);
+        ps2_dma_decode();
+    }
+    return pbuf_dequeue();
+}
+
+uint8_t ps2_host_recv(void) {
+    ps2_dma_decode();
+    if (pbuf_has_data()) {
+        ps2_error = PS2_ERR_NONE;
+        return pbuf_dequeue();
+    } else {
+        ps2_error = PS2_ERR_NODATA;
+        return 0;
+    }
+}
+
+uint8_t ps2_host_recv_available(void) {
+    ps2_dma_decode();
+    return pbuf_size();
+}
+
+/* send LED state to keyboard */
+void ps2_host_set_led(uint8_t led) {
+    ps2_host_send(0xED);
+    ps2_host_send(led);
+}
+
+/*--------------------------------------------------------------------
+ * Ring buffer to store received bytes, only touched from the main loop
+ *------------------------------------------------------------------*/
+#define PBUF_SIZE 32
+SPSC_QUEUE(pbuf, uint8_t, PBUF_SIZE);
+
+static inline void pbuf_enqueue(uint8_t data) {
+    if (!pbuf_push(data)) {
+        print("pbuf: full\n");
+    }
+}
+static inline uint8_t pbuf_dequeue(void) {
+    uint8_t val = 0;
+    pbuf_pop(&val);
+    return val;
+}
+static inline bool pbuf_has_data(void) {
+    return !pbuf_empty();
+}
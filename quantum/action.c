@@ -38,6 +38,10 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #    include "nodebug.h"
 #endif
 
+#ifdef PREDICTIVE_TAP_HOLD_ENABLE
+#    include "predictive_tap_hold.h"
+#endif
+
 #ifdef POINTING_DEVICE_ENABLE
 #    include "pointing_device.h"
 #endif
@@ -88,6 +92,8 @@ void action_exec(keyevent_t event) {
         clear_weak_mods();
     }
 
+    layer_state_defer_begin();
+
 #ifdef SWAP_HANDS_ENABLE
     if (!IS_NOEVENT(event)) {
         process_hand_swap(&event);
@@ -133,6 +139,8 @@ void action_exec(keyevent_t event) {
         dprintln();
     }
 #endif
+
+    layer_state_defer_end();
 }
 
 #ifdef SWAP_HANDS_ENABLE
@@ -225,6 +233,9 @@ void process_record(keyrecord_t *record) {
 
     process_record_handler(record);
     post_process_record_quantum(record);
+#ifdef PREDICTIVE_TAP_HOLD_ENABLE
+    predictive_tap_hold_settled(record);
+#endif
 }
 
 void process_record_handler(keyrecord_t *record) {
@@ -428,12 +439,7 @@ void process_action(keyrecord_t *record, action_t action) {
                     } else {
                         if (tap_count > 0) {
                             dprint("MODS_TAP: Tap: unregister_code\n");
-                            if (action.layer_tap.code == KC_CAPS_LOCK) {
-                                wait_ms(TAP_HOLD_CAPS_DELAY);
-                            } else {
-                                wait_ms(TAP_CODE_DELAY);
-                            }
-                            unregister_code(action.key.code);
+                            unregister_code_delay(action.key.code, action.layer_tap.code == KC_CAPS_LOCK ? TAP_HOLD_CAPS_DELAY : TAP_CODE_DELAY);
                         } else {
                             dprint("MODS_TAP: No tap: add_mods\n");
                             unregister_mods(mods);
@@ -627,12 +633,7 @@ void process_action(keyrecord_t *record, action_t action) {
                     } else {
                         if (tap_count > 0) {
                             dprint("KEYMAP_TAP_KEY: Tap: unregister_code\n");
-                            if (action.layer_tap.code == KC_CAPS_LOCK) {
-                                wait_ms(TAP_HOLD_CAPS_DELAY);
-                            } else {
-                                wait_ms(TAP_CODE_DELAY);
-                            }
-                            unregister_code(action.layer_tap.code);
+                            unregister_code_delay(action.layer_tap.code, action.layer_tap.code == KC_CAPS_LOCK ? TAP_HOLD_CAPS_DELAY : TAP_CODE_DELAY);
                         } else {
                             dprint("KEYMAP_TAP_KEY: No tap: Off on release\n");
                             layer_off(action.layer_tap.val);
@@ -704,8 +705,7 @@ void process_action(keyrecord_t *record, action_t action) {
                         if (event.pressed) {
                             register_code(action.swap.code);
                         } else {
-                            wait_ms(TAP_CODE_DELAY);
-                            unregister_code(action.swap.code);
+                            unregister_code_delay(action.swap.code, TAP_CODE_DELAY);
                             *record = (keyrecord_t){}; // hack: reset tap mode
                         }
                     } else {
@@ -794,6 +794,10 @@ void process_action(keyrecord_t *record, action_t action) {
  * FIXME: Needs documentation.
  */
 __attribute__((weak)) void register_code(uint8_t code) {
+#ifdef TAP_CODE_DEFER_RELEASE
+    // send queued taps first so they do not overlap this press
+    scheduled_unregister_settle();
+#endif
     if (code == KC_NO) {
         return;
     }
@@ -856,7 +860,7 @@ __attribute__((weak)) void register_code(uint8_t code) {
             // Force a new key press if the key is already pressed
             // without this, keys with the same keycode, but different
             // modifiers will be reported incorrectly, see issue #1708
-            if (is_key_pressed(keyboard_report, code)) {
+            if (is_key_registered(code)) {
                 del_key(code);
                 send_keyboard_report();
             }
@@ -942,17 +946,36 @@ __attribute__((weak)) void unregister_code(uint8_t code) {
 #endif
 }
 
+/** \brief Unregister a keycode once it has been registered for the given delay.
+ *
+ * With TAP_CODE_DEFER_RELEASE the release is queued and this returns immediately, otherwise it blocks for the delay.
+ *
+ * \param code The basic keycode to unregister.
+ * \param delay The amount of time in milliseconds to leave the keycode registered.
+ */
+void unregister_code_delay(uint8_t code, uint16_t delay) {
+#ifdef TAP_CODE_DEFER_RELEASE
+    schedule_unregister_code16(code, delay);
+#else
+    for (uint16_t i = delay; i > 0; i--) {
+        wait_ms(1);
+    }
+    unregister_code(code);
+#endif
+}
+
 /** \brief Tap a keycode with a delay.
  *
  * \param code The basic keycode to tap.
  * \param delay The amount of time in milliseconds to leave the keycode registered, before unregistering it.
  */
 __attribute__((weak)) void tap_code_delay(uint8_t code, uint16_t delay) {
+#ifdef TAP_CODE_DEFER_RELEASE
+    schedule_tap_code16(code, delay);
+#else
     register_code(code);
-    for (uint16_t i = delay; i > 0; i--) {
-        wait_ms(1);
-    }
-    unregister_code(code);
+    unregister_code_delay(code, delay);
+#endif
 }
 
 /** \brief Tap a keycode with the default delay.
@@ -1012,6 +1035,9 @@ __attribute__((weak)) void unregister_weak_mods(uint8_t mods) {
  * FIXME: Needs documentation.
  */
 void clear_keyboard(void) {
+#ifdef TAP_CODE_DEFER_RELEASE
+    scheduled_unregister_flush();
+#endif
     clear_mods();
     clear_keyboard_but_mods();
 }
@@ -1106,7 +1132,11 @@ bool is_tap_action(action_t action) {
  * FIXME: Needs documentation.
  */
 void debug_event(keyevent_t event) {
+#ifdef DEFERRED_LOG_ENABLE
+    dlog("%04X%c(%u)", (event.key.row << 8 | event.key.col), (event.pressed ? 'd' : 'u'), event.time);
+#else
     dprintf("%04X%c(%u)", (event.key.row << 8 | event.key.col), (event.pressed ? 'd' : 'u'), event.time);
+#endif
 }
 /** \brief Debug print (FIXME: Needs better description)
  *
@@ -1115,7 +1145,11 @@ void debug_event(keyevent_t event) {
 void debug_record(keyrecord_t record) {
     debug_event(record.event);
 #ifndef NO_ACTION_TAPPING
+#    ifdef DEFERRED_LOG_ENABLE
+    dlog(":%u%c", record.tap.count, (record.tap.interrupted ? '-' : ' '));
+#    else
     dprintf(":%u%c", record.tap.count, (record.tap.interrupted ? '-' : ' '));
+#    endif
 #endif
 }
 
@@ -34,6 +34,9 @@ extern "C" {
 #ifndef TAP_HOLD_CAPS_DELAY
 #    define TAP_HOLD_CAPS_DELAY 80
 #endif
+#ifndef TAP_CODE_DEFER_RELEASE_QUEUE_SIZE
+#    define TAP_CODE_DEFER_RELEASE_QUEUE_SIZE 8
+#endif
 
 /* tapping count and state */
 typedef struct {
@@ -94,8 +97,16 @@ void post_process_record_quantum(keyrecord_t *record);
 void process_action(keyrecord_t *record, action_t action);
 void register_code(uint8_t code);
 void unregister_code(uint8_t code);
+void unregister_code_delay(uint8_t code, uint16_t delay);
 void tap_code(uint8_t code);
 void tap_code_delay(uint8_t code, uint16_t delay);
+#ifdef TAP_CODE_DEFER_RELEASE
+void schedule_unregister_code16(uint16_t code, uint16_t delay);
+void schedule_tap_code16(uint16_t code, uint16_t delay);
+void scheduled_unregister_settle(void);
+void scheduled_unregister_flush(void);
+void scheduled_unregister_task(void);
+#endif
 void register_mods(uint8_t mods);
 void unregister_mods(uint8_t mods);
 void register_weak_mods(uint8_t mods);
@@ -110,11 +110,34 @@ __attribute__((weak)) layer_state_t layer_state_set_kb(layer_state_t state) {
     return layer_state_set_user(state);
 }
 
-/** \brief Layer state set
+/** \brief Layer state changed user
  *
- * Sets the layer to match the specifed state (a bitmask)
+ * Runs user code once the new layer state has been applied
  */
-void layer_state_set(layer_state_t state) {
+__attribute__((weak)) void layer_state_changed_user(layer_state_t state, layer_state_t changed) {}
+
+/** \brief Layer state changed keyboard
+ *
+ * Runs keyboard code once the new layer state has been applied
+ */
+__attribute__((weak)) void layer_state_changed_kb(layer_state_t state, layer_state_t changed) {
+    layer_state_changed_user(state, changed);
+}
+
+#    ifdef LAYER_STATE_DEFER
+static uint8_t       layer_state_defer_depth = 0;
+static layer_state_t layer_state_committed   = 0;
+#    endif
+
+/** \brief Layer state commit
+ *
+ * Applies the state and notifies the observers, prints debug info and clears keys
+ */
+static void layer_state_commit(layer_state_t state) {
+    layer_state_t previous = layer_state;
+#    ifdef LAYER_STATE_DEFER
+    previous = layer_state_committed;
+#    endif
     state = layer_state_set_kb(state);
     dprint("layer_state: ");
     layer_debug();
@@ -127,8 +150,54 @@ void layer_state_set(layer_state_t state) {
 #    else
     clear_keyboard_but_mods_and_keys(); // Don't reset held keys
 #    endif
+#    ifdef LAYER_STATE_DEFER
+    layer_state_committed = state;
+#    endif
+    if (state != previous) {
+        layer_state_changed_kb(state, state ^ previous);
+    }
+}
+
+/** \brief Layer state set
+ *
+ * Sets the layer to match the specifed state (a bitmask)
+ */
+void layer_state_set(layer_state_t state) {
+#    ifdef LAYER_STATE_DEFER
+    if (layer_state_defer_depth) {
+        // only the keymap lookups see the new state until the pass ends
+        layer_state = state;
+        return;
+    }
+#    endif
+    layer_state_commit(state);
+}
+
+#    ifdef LAYER_STATE_DEFER
+/** \brief Layer state defer begin
+ *
+ * Starts accumulating layer changes instead of running the callbacks for each of them
+ */
+void layer_state_defer_begin(void) {
+    if (!layer_state_defer_depth++) {
+        layer_state_committed = layer_state;
+    }
 }
 
+/** \brief Layer state defer end
+ *
+ * Runs the callbacks once for the state accumulated since the outermost layer_state_defer_begin()
+ */
+void layer_state_defer_end(void) {
+    if (!layer_state_defer_depth || --layer_state_defer_depth) {
+        return;
+    }
+    if (layer_state != layer_state_committed) {
+        layer_state_commit(layer_state);
+    }
+}
+#    endif
+
 /** \brief Layer clear
  *
  * Turn off all layers
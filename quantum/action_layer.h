@@ -112,6 +112,18 @@ void          layer_and(layer_state_t state);
 void          layer_xor(layer_state_t state);
 layer_state_t layer_state_set_user(layer_state_t state);
 layer_state_t layer_state_set_kb(layer_state_t state);
+void          layer_state_changed_user(layer_state_t state, layer_state_t changed);
+void          layer_state_changed_kb(layer_state_t state, layer_state_t changed);
+#    ifdef LAYER_STATE_DEFER
+#        ifdef STRICT_LAYER_RELEASE
+#            error "LAYER_STATE_DEFER cannot be used with STRICT_LAYER_RELEASE"
+#        endif
+void layer_state_defer_begin(void);
+void layer_state_defer_end(void);
+#    else
+#        define layer_state_defer_begin()
+#        define layer_state_defer_end()
+#    endif
 #else
 #    define layer_state 0
 
@@ -130,6 +142,8 @@ layer_state_t layer_state_set_kb(layer_state_t state);
 #    define layer_xor(state) (void)state
 #    define layer_state_set_kb(state) (void)state
 #    define layer_state_set_user(state) (void)state
+#    define layer_state_defer_begin()
+#    define layer_state_defer_end()
 #endif
 
 /* pressed actions cache */
@@ -12,6 +12,14 @@
 #    include "nodebug.h"
 #endif
 
+#if defined(DEFERRED_LOG_ENABLE) && defined(DEBUG_ACTION) && !defined(NO_DEBUG)
+// every message in this file is a literal, queue them instead of printing inline
+#    undef debug
+#    undef debug_dec
+#    define debug(s) dlog(s)
+#    define debug_dec(data) dlog("%u", data)
+#endif
+
 #ifndef NO_ACTION_TAPPING
 
 #    define IS_TAPPING() !IS_NOEVENT(tapping_key.event)
@@ -58,6 +66,10 @@ __attribute__((weak)) bool get_hold_on_other_key_press(uint16_t keycode, keyreco
 #        include "process_auto_shift.h"
 #    endif
 
+#    ifdef PREDICTIVE_TAP_HOLD_ENABLE
+#        include "predictive_tap_hold.h"
+#    endif
+
 static keyrecord_t tapping_key                         = {};
 static keyrecord_t waiting_buffer[WAITING_BUFFER_SIZE] = {};
 static uint8_t     waiting_buffer_head                 = 0;
@@ -77,6 +89,14 @@ static void debug_waiting_buffer(void);
  * FIXME: Needs doc
  */
 void action_tapping_process(keyrecord_t record) {
+#    ifdef PREDICTIVE_TAP_HOLD_ENABLE
+    predictive_tap_hold_observe(&record);
+    if (predictive_tap_hold_consume_release(record.event)) {
+        // the tap was already sent in full when it was predicted
+        debug("Tapping: release of predicted tap\n");
+        record.event.key = (keypos_t){.row = 255, .col = 255};
+    }
+#    endif
     if (process_tapping(&record)) {
         if (!IS_NOEVENT(record.event)) {
             debug("processed: ");
@@ -257,6 +277,9 @@ bool process_tapping(keyrecord_t *keyp) {
                 } else {
                     // set interrupted flag when other key preesed during tapping
                     if (event.pressed) {
+#    ifdef PREDICTIVE_TAP_HOLD_ENABLE
+                        bool first_interrupt = !tapping_key.tap.interrupted;
+#    endif
                         tapping_key.tap.interrupted = true;
 #    if defined(HOLD_ON_OTHER_KEY_PRESS) || defined(HOLD_ON_OTHER_KEY_PRESS_PER_KEY)
 #        if defined(HOLD_ON_OTHER_KEY_PRESS_PER_KEY)
@@ -270,6 +293,21 @@ bool process_tapping(keyrecord_t *keyp) {
                             // enqueue
                             return false;
                         }
+#    endif
+#    ifdef PREDICTIVE_TAP_HOLD_ENABLE
+                        if (first_interrupt && predictive_tap_hold_decide(&tapping_key, event)) {
+                            // Settle the tap now instead of at release. Press and release are both
+                            // sent so the queued key lands after a complete tap.
+                            debug("Tapping: End. Predicted tap(0->1).\n");
+                            tapping_key.tap.count = 1;
+                            process_record(&tapping_key);
+                            tapping_key.event.pressed = false;
+                            tapping_key.event.time    = event.time;
+                            process_record(&tapping_key);
+                            debug_tapping_key();
+                            // enqueue
+                            return false;
+                        }
 #    endif
                     }
                     // enqueue
@@ -21,6 +21,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "action_layer.h"
 #include "timer.h"
 #include "keycode_config.h"
+#include "util.h"
 #include <string.h>
 
 extern keymap_config_t keymap_config;
@@ -36,9 +37,134 @@ static uint8_t suppressed_mods    = 0;
 // report_keyboard_t keyboard_report = {};
 report_keyboard_t *keyboard_report = &(report_keyboard_t){};
 
-extern inline void add_key(uint8_t key);
-extern inline void del_key(uint8_t key);
-extern inline void clear_keys(void);
+/* Every registered key is tracked in a bitmap so keyboard_report can be kept
+ * up to date one key at a time: adding or deleting a key only touches a single
+ * byte or bit of the report instead of scanning it, and the report is only
+ * rebuilt from the bitmap when the host switches between 6KRO and NKRO.
+ */
+static uint8_t keys_pressed[32] = {0};
+static uint8_t keys_count       = 0;
+static bool    keys_dirty       = false;
+#ifndef PROTOCOL_VUSB
+static uint8_t keys_sent_mods = 0;
+#endif
+#ifndef RING_BUFFERED_6KRO_REPORT_ENABLE
+static uint8_t keys_slots = 0; // occupied entries of keyboard_report->keys
+#endif
+#ifdef NKRO_ENABLE
+static bool keys_nkro = false; // format keyboard_report is currently built in
+#endif
+
+static inline bool report_is_nkro(void) {
+#ifdef NKRO_ENABLE
+    return keyboard_protocol && keymap_config.nkro;
+#else
+    return false;
+#endif
+}
+
+static void report_add(uint8_t key) {
+#ifdef NKRO_ENABLE
+    if (keys_nkro) {
+        add_key_bit(keyboard_report, key);
+        return;
+    }
+#endif
+#ifdef RING_BUFFERED_6KRO_REPORT_ENABLE
+    add_key_byte(keyboard_report, key);
+#else
+    uint8_t free = ~keys_slots & ((1 << KEYBOARD_REPORT_KEYS) - 1);
+    if (free) {
+        uint8_t slot                = biton(free & -free);
+        keyboard_report->keys[slot] = key;
+        keys_slots |= (1 << slot);
+    }
+#endif
+}
+
+static void report_del(uint8_t key) {
+#ifdef NKRO_ENABLE
+    if (keys_nkro) {
+        del_key_bit(keyboard_report, key);
+        return;
+    }
+#endif
+#ifdef RING_BUFFERED_6KRO_REPORT_ENABLE
+    del_key_byte(keyboard_report, key);
+#else
+    for (uint8_t slots = keys_slots; slots; slots &= slots - 1) {
+        uint8_t slot = biton(slots & -slots);
+        if (keyboard_report->keys[slot] == key) {
+            keyboard_report->keys[slot] = 0;
+            keys_slots &= ~(1 << slot);
+            return;
+        }
+    }
+#endif
+}
+
+#ifdef NKRO_ENABLE
+/** \brief Rebuilds keyboard_report from the key bitmap
+ *
+ * Only needed when the report format changes, mods are left untouched.
+ */
+static void report_rebuild(void) {
+    uint8_t mods = keyboard_report->mods;
+    memset(keyboard_report, 0, sizeof(report_keyboard_t));
+    keyboard_report->mods = mods;
+#    ifdef RING_BUFFERED_6KRO_REPORT_ENABLE
+    // also rewinds the ring buffer in report.c
+    clear_keys_from_report(keyboard_report);
+#    else
+    keys_slots = 0;
+#    endif
+    keys_nkro = report_is_nkro();
+    for (uint8_t i = 0; i < sizeof(keys_pressed); i++) {
+        for (uint8_t bits = keys_pressed[i]; bits; bits &= bits - 1) {
+            report_add((i << 3) | biton(bits & -bits));
+        }
+    }
+    keys_dirty = true;
+}
+#endif
+
+/* key */
+void add_key(uint8_t key) {
+    if (keys_pressed[key >> 3] & (1 << (key & 7))) {
+        return;
+    }
+    keys_pressed[key >> 3] |= (1 << (key & 7));
+    keys_count++;
+    report_add(key);
+    keys_dirty = true;
+}
+
+void del_key(uint8_t key) {
+    if (!(keys_pressed[key >> 3] & (1 << (key & 7)))) {
+        return;
+    }
+    keys_pressed[key >> 3] &= ~(1 << (key & 7));
+    keys_count--;
+    report_del(key);
+    keys_dirty = true;
+}
+
+void clear_keys(void) {
+    if (!keys_count) {
+        return;
+    }
+    memset(keys_pressed, 0, sizeof(keys_pressed));
+    keys_count = 0;
+    clear_keys_from_report(keyboard_report);
+#ifndef RING_BUFFERED_6KRO_REPORT_ENABLE
+    keys_slots = 0;
+#endif
+    keys_dirty = true;
+}
+
+bool is_key_registered(uint8_t key) {
+    return keys_pressed[key >> 3] & (1 << (key & 7));
+}
 
 #ifndef NO_ACTION_ONESHOT
 static uint8_t oneshot_mods        = 0;
@@ -245,6 +371,11 @@ bool is_oneshot_enabled(void) {
  * FIXME: needs doc
  */
 void send_keyboard_report(void) {
+#ifdef NKRO_ENABLE
+    if (keys_nkro != report_is_nkro()) {
+        report_rebuild();
+    }
+#endif
     keyboard_report->mods = real_mods;
     keyboard_report->mods |= weak_mods;
 
@@ -257,7 +388,7 @@ void send_keyboard_report(void) {
         }
 #    endif
         keyboard_report->mods |= oneshot_mods;
-        if (has_anykey(keyboard_report)) {
+        if (keys_count) {
             clear_oneshot_mods();
         }
     }
@@ -273,11 +404,10 @@ void send_keyboard_report(void) {
 #ifdef PROTOCOL_VUSB
     host_keyboard_send(keyboard_report);
 #else
-    static report_keyboard_t last_report;
-
     /* Only send the report if there are changes to propagate to the host. */
-    if (memcmp(keyboard_report, &last_report, sizeof(report_keyboard_t)) != 0) {
-        memcpy(&last_report, keyboard_report, sizeof(report_keyboard_t));
+    if (keys_dirty || keyboard_report->mods != keys_sent_mods) {
+        keys_dirty     = false;
+        keys_sent_mods = keyboard_report->mods;
         host_keyboard_send(keyboard_report);
     }
 #endif
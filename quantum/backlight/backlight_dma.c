@@ -0,0 +1,339 @@
+#include "quantum.h"
+#include "backlight.h"
+#include "backlight_driver_common.h"
+
+#ifndef PROTOCOL_CHIBIOS
+#    error "The dma backlight driver is only available on ChibiOS"
+#endif
+
+#include <hal.h>
+
+/* Software PWM played out by DMA
+ *
+ * Every timer update event copies one word of the waveform buffer into the
+ * BSRR register of the backlight port. The buffer holds two PWM periods; the
+ * half that is not being played out is refilled from the DMA half and full
+ * transfer interrupts, which is the only time the CPU is involved while breathing.
+ */
+
+#if !defined(BACKLIGHT_PIN) && !defined(BACKLIGHT_PINS)
+#    error "Backlight pin/pins not defined. Please configure."
+#endif
+
+// Maximum duty cycle limit
+#ifndef BACKLIGHT_LIMIT_VAL
+#    define BACKLIGHT_LIMIT_VAL 255
+#endif
+
+#ifndef BACKLIGHT_GPT_DRIVER
+#    error "please specify in your config.h: #define BACKLIGHT_GPT_DRIVER GPTD? (a timer enabled with STM32_GPT_USE_TIM? in mcuconf.h)"
+#endif
+#ifndef BACKLIGHT_DMA_STREAM
+#    error "please consult your MCU's datasheet and specify in your config.h: #define BACKLIGHT_DMA_STREAM STM32_DMA?_STREAM? (DMA stream for the update event of BACKLIGHT_GPT_DRIVER)"
+#endif
+#ifndef BACKLIGHT_DMA_CHANNEL
+#    define BACKLIGHT_DMA_CHANNEL 0 // DMA Channel for TIMx_UP
+#endif
+#if (STM32_DMA_SUPPORTS_DMAMUX == TRUE) && !defined(BACKLIGHT_DMAMUX_ID)
+#    error "please consult your MCU's datasheet and specify in your config.h: #define BACKLIGHT_DMAMUX_ID STM32_DMAMUX1_TIM?_UP"
+#endif
+
+// Number of time slots in one PWM period, sets the resolution of the duty cycle
+#ifndef BACKLIGHT_DMA_STEPS
+#    define BACKLIGHT_DMA_STEPS 64
+#endif
+// PWM frequency in Hz
+#ifndef BACKLIGHT_DMA_PWM_FREQUENCY
+#    define BACKLIGHT_DMA_PWM_FREQUENCY 256
+#endif
+
+#if BACKLIGHT_DMA_STEPS > 255
+#    error "BACKLIGHT_DMA_STEPS must not exceed 255"
+#endif
+
+#define BACKLIGHT_DMA_TIMER_FREQUENCY 1000000
+#define BACKLIGHT_DMA_INTERVAL (BACKLIGHT_DMA_TIMER_FREQUENCY / (BACKLIGHT_DMA_PWM_FREQUENCY * BACKLIGHT_DMA_STEPS))
+
+#if BACKLIGHT_DMA_INTERVAL < 2
+#    error "BACKLIGHT_DMA_PWM_FREQUENCY * BACKLIGHT_DMA_STEPS is too high"
+#endif
+
+#if defined(BACKLIGHT_PINS)
+static const pin_t backlight_pins[] = BACKLIGHT_PINS;
+#else
+static const pin_t backlight_pins[] = {BACKLIGHT_PIN};
+#endif
+#define BACKLIGHT_PIN_COUNT (sizeof(backlight_pins) / sizeof(pin_t))
+
+_Static_assert(BACKLIGHT_PIN_COUNT <= 8, "The dma backlight driver supports up to 8 pins");
+
+/* The preprocessor cannot see which port a pin is on, so the check is left to
+ * the compiler: every call below is folded away unless a pin is on another port.
+ */
+#ifdef __OPTIMIZE__
+extern void backlight_dma_pins_on_different_ports(void) __attribute__((error("all backlight pins must be on the same GPIO port")));
+#    define BACKLIGHT_DMA_PIN(i) backlight_pins[(i) < BACKLIGHT_PIN_COUNT ? (i) : 0]
+#    define BACKLIGHT_DMA_CHECK_PORT(i)                                                 \
+        do {                                                                            \
+            if (PAL_PORT(BACKLIGHT_DMA_PIN(i)) != PAL_PORT(BACKLIGHT_DMA_PIN(0))) {     \
+                backlight_dma_pins_on_different_ports();                                \
+            }                                                                           \
+        } while (0)
+#else
+#    define BACKLIGHT_DMA_CHECK_PORT(i)
+#endif
+
+static uint32_t backlight_dma_buffer[2][BACKLIGHT_DMA_STEPS];
+static uint8_t  backlight_dma_slots[2] = {0, 0}; // on slots currently written to each half
+static uint32_t backlight_on_word      = 0;
+static uint32_t backlight_off_word     = 0;
+static bool     backlight_dma_running  = false;
+
+// See http://jared.geek.nz/2013/feb/linear-led-pwm
+static uint16_t cie_lightness(uint16_t v) {
+    if (v <= 5243)    // if below 8% of max
+        return v / 9; // same as dividing by 900%
+    else {
+        uint32_t y = (((uint32_t)v + 10486) << 8) / (10486 + 0xFFFFUL); // add 16% of max and compare
+        // to get a useful result with integer division, we shift left in the expression above
+        // and revert what we've done again after squaring.
+        y = y * y * y >> 8;
+        if (y > 0xFFFFUL) // prevent overflow
+            return 0xFFFFU;
+        else
+            return (uint16_t)y;
+    }
+}
+
+static uint32_t rescale_limit_val(uint32_t val) {
+    // rescale the supplied backlight value to be in terms of the value limit
+    return (val * (BACKLIGHT_LIMIT_VAL + 1)) / 256;
+}
+
+/* Number of slots the pins are on for a 16 bit duty cycle. Anything above
+ * zero keeps at least one slot, so the lowest levels do not go dark.
+ */
+static uint8_t duty_to_slots(uint16_t duty) {
+    uint8_t slots = ((uint32_t)duty * BACKLIGHT_DMA_STEPS + 0x8000) >> 16;
+    return (duty && !slots) ? 1 : slots;
+}
+
+/* Only the slots between the old and the new duty cycle are rewritten. */
+static void backlight_dma_fill(uint8_t half, uint8_t slots) {
+    uint32_t *buffer = backlight_dma_buffer[half];
+    uint8_t   from   = backlight_dma_slots[half];
+
+    if (slots > from) {
+        for (uint8_t i = from; i < slots; i++) {
+            buffer[i] = backlight_on_word;
+        }
+    } else {
+        for (uint8_t i = slots; i < from; i++) {
+            buffer[i] = backlight_off_word;
+        }
+    }
+    backlight_dma_slots[half] = slots;
+}
+
+#ifdef BACKLIGHT_BREATHING
+// breathing refills each half of the buffer once it has been played out
+#    define BACKLIGHT_DMA_IRQ_FLAGS (STM32_DMA_CR_HTIE | STM32_DMA_CR_TCIE)
+static void backlight_dma_isr(void *param, uint32_t flags);
+#else
+#    define BACKLIGHT_DMA_IRQ_FLAGS 0
+#endif
+
+static void backlight_dma_configure(bool enable) {
+    static const GPTConfig gptcfg = {
+        .frequency = BACKLIGHT_DMA_TIMER_FREQUENCY,
+        .callback  = NULL,
+        .cr2       = 0,
+        .dier      = STM32_TIM_DIER_UDE, // DMA on update event
+    };
+
+    if (enable == backlight_dma_running) {
+        return;
+    }
+
+    if (enable) {
+        dmaStreamSetPeripheral(BACKLIGHT_DMA_STREAM, &PAL_PORT(backlight_pins[0])->BSRR);
+        dmaStreamSetMemory0(BACKLIGHT_DMA_STREAM, backlight_dma_buffer);
+        dmaStreamSetTransactionSize(BACKLIGHT_DMA_STREAM, 2 * BACKLIGHT_DMA_STEPS);
+        dmaStreamSetMode(BACKLIGHT_DMA_STREAM, STM32_DMA_CR_CHSEL(BACKLIGHT_DMA_CHANNEL) | STM32_DMA_CR_DIR_M2P | STM32_DMA_CR_PSIZE_WORD | STM32_DMA_CR_MSIZE_WORD | STM32_DMA_CR_MINC | STM32_DMA_CR_CIRC | STM32_DMA_CR_PL(0) | BACKLIGHT_DMA_IRQ_FLAGS);
+#if (STM32_DMA_SUPPORTS_DMAMUX == TRUE)
+        // If the MCU has a DMAMUX we need to assign the correct resource
+        dmaSetRequestSource(BACKLIGHT_DMA_STREAM, BACKLIGHT_DMAMUX_ID);
+#endif
+        dmaStreamEnable(BACKLIGHT_DMA_STREAM);
+
+        gptStart(&BACKLIGHT_GPT_DRIVER, &gptcfg);
+        gptStartContinuous(&BACKLIGHT_GPT_DRIVER, BACKLIGHT_DMA_INTERVAL);
+    } else {
+        gptStopTimer(&BACKLIGHT_GPT_DRIVER);
+        gptStop(&BACKLIGHT_GPT_DRIVER);
+        dmaStreamDisable(BACKLIGHT_DMA_STREAM);
+        backlight_pins_off();
+    }
+    backlight_dma_running = enable;
+}
+
+void backlight_init_ports(void) {
+    backlight_pins_init();
+
+    BACKLIGHT_DMA_CHECK_PORT(1);
+    BACKLIGHT_DMA_CHECK_PORT(2);
+    BACKLIGHT_DMA_CHECK_PORT(3);
+    BACKLIGHT_DMA_CHECK_PORT(4);
+    BACKLIGHT_DMA_CHECK_PORT(5);
+    BACKLIGHT_DMA_CHECK_PORT(6);
+    BACKLIGHT_DMA_CHECK_PORT(7);
+
+    // BSRR: the low half sets pins, the high half resets them
+    for (uint8_t i = 0; i < BACKLIGHT_PIN_COUNT; i++) {
+#if BACKLIGHT_ON_STATE == 0
+        backlight_on_word |= PAL_PORT_BIT(PAL_PAD(backlight_pins[i])) << 16;
+        backlight_off_word |= PAL_PORT_BIT(PAL_PAD(backlight_pins[i]));
+#else
+        backlight_on_word |= PAL_PORT_BIT(PAL_PAD(backlight_pins[i]));
+        backlight_off_word |= PAL_PORT_BIT(PAL_PAD(backlight_pins[i])) << 16;
+#endif
+    }
+    for (uint8_t i = 0; i < BACKLIGHT_DMA_STEPS; i++) {
+        backlight_dma_buffer[0][i] = backlight_off_word;
+        backlight_dma_buffer[1][i] = backlight_off_word;
+    }
+
+#ifdef BACKLIGHT_BREATHING
+    dmaStreamAlloc(BACKLIGHT_DMA_STREAM - STM32_DMA_STREAM(0), 10, backlight_dma_isr, NULL);
+#else
+    dmaStreamAlloc(BACKLIGHT_DMA_STREAM - STM32_DMA_STREAM(0), 10, NULL, NULL);
+#endif
+
+    backlight_set(get_backlight_level());
+
+#ifdef BACKLIGHT_BREATHING
+    if (is_backlight_breathing()) {
+        breathing_enable();
+    }
+#endif
+}
+
+#ifdef BACKLIGHT_BREATHING
+static uint8_t backlight_level_slots = 0; // steady output, restored after a pulse
+static void    breathing_update_curve(void);
+#endif
+
+void backlight_set(uint8_t level) {
+    if (level > BACKLIGHT_LEVELS) level = BACKLIGHT_LEVELS;
+
+    uint8_t slots = duty_to_slots(cie_lightness(rescale_limit_val(0xFFFF * (uint32_t)level / BACKLIGHT_LEVELS)));
+
+#ifdef BACKLIGHT_BREATHING
+    backlight_level_slots = slots;
+    breathing_update_curve();
+    if (is_breathing()) {
+        backlight_dma_configure(level != 0);
+        return;
+    }
+#endif
+
+    // a half that is being played out just finishes its period with the old duty cycle
+    osalSysLock();
+    backlight_dma_fill(0, slots);
+    backlight_dma_fill(1, slots);
+    osalSysUnlock();
+
+    backlight_dma_configure(level != 0);
+}
+
+void backlight_task(void) {}
+
+#ifdef BACKLIGHT_BREATHING
+
+#    define BREATHING_STEPS 128
+// a pulse holds the buffer for about 10ms
+#    define BREATHING_PULSE_PERIODS (BACKLIGHT_DMA_PWM_FREQUENCY / 100 + 1)
+
+/* To generate breathing curve in python:
+ * from math import sin, pi; [int(sin(x/128.0*pi)**4*255) for x in range(128)]
+ */
+static const uint8_t breathing_table[BREATHING_STEPS] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 2, 3, 4, 5, 6, 8, 10, 12, 15, 17, 20, 24, 28, 32, 36, 41, 46, 51, 57, 63, 70, 76, 83, 91, 98, 106, 113, 121, 129, 138, 146, 154, 162, 170, 178, 185, 193, 200, 207, 213, 220, 225, 231, 235, 240, 244, 247, 250, 252, 253, 254, 255, 254, 253, 252, 250, 247, 244, 240, 235, 231, 225, 220, 213, 207, 200, 193, 185, 178, 170, 162, 154, 146, 138, 129, 121, 113, 106, 98, 91, 83, 76, 70, 63, 57, 51, 46, 41, 36, 32, 28, 24, 20, 17, 15, 12, 10, 8, 6, 5, 4, 3, 2, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+
+// breathing_table scaled to the current level, in slots
+static uint8_t  breathing_slots[BREATHING_STEPS];
+static bool     breathing         = false;
+static uint32_t breathing_counter = 0;
+static uint8_t  pulse_periods     = 0;
+
+// Use this before the cie_lightness function.
+static inline uint16_t scale_backlight(uint16_t v) {
+    return v / BACKLIGHT_LEVELS * get_backlight_level();
+}
+
+/* The curve only depends on the level, so it is computed here rather than on every PWM period. */
+static void breathing_update_curve(void) {
+    for (uint8_t i = 0; i < BREATHING_STEPS; i++) {
+        breathing_slots[i] = duty_to_slots(cie_lightness(rescale_limit_val(scale_backlight(breathing_table[i] * 256))));
+    }
+}
+
+static uint8_t breathing_index(void) {
+    uint32_t period = (uint32_t)get_breathing_period() * BACKLIGHT_DMA_PWM_FREQUENCY;
+    return breathing_counter * BREATHING_STEPS / period;
+}
+
+/* Runs once per PWM period, when DMA moves on to the other half of the buffer. */
+static void backlight_dma_isr(void *param, uint32_t flags) {
+    (void)param;
+
+    if (pulse_periods) {
+        if (--pulse_periods == 0) {
+            uint8_t slots = breathing ? breathing_slots[breathing_index()] : backlight_level_slots;
+            backlight_dma_fill(0, slots);
+            backlight_dma_fill(1, slots);
+        }
+        return;
+    }
+
+    if (!breathing) {
+        return;
+    }
+
+    uint32_t period = (uint32_t)get_breathing_period() * BACKLIGHT_DMA_PWM_FREQUENCY;
+    // resetting after one period to prevent ugly reset at overflow.
+    breathing_counter = (breathing_counter + 1) % period;
+
+    // the half that just finished playing out gets the next period
+    backlight_dma_fill((flags & STM32_DMA_ISR_TCIF) ? 1 : 0, breathing_slots[breathing_index()]);
+}
+
+bool is_breathing(void) {
+    return breathing;
+}
+
+void breathing_enable(void) {
+    breathing_counter = 0;
+    breathing         = true;
+}
+
+void breathing_disable(void) {
+    breathing = false;
+
+    // Restore backlight level
+    backlight_set(get_backlight_level());
+}
+
+/* Flips the output for a few periods; the interrupt restores it, so this does not block. */
+void breathing_pulse(void) {
+    uint8_t slots = is_backlight_enabled() ? 0 : BACKLIGHT_DMA_STEPS;
+
+    osalSysLock();
+    pulse_periods = BREATHING_PULSE_PERIODS;
+    backlight_dma_fill(0, slots);
+    backlight_dma_fill(1, slots);
+    osalSysUnlock();
+
+    backlight_dma_configure(true);
+}
+
+#endif
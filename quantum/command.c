@@ -47,6 +47,22 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #    include "audio.h"
 #endif /* AUDIO_ENABLE */
 
+#ifdef PREDICTIVE_TAP_HOLD_ENABLE
+#    include "predictive_tap_hold.h"
+#endif
+
+#ifdef TASK_SCHEDULER_ENABLE
+#    include "task_scheduler.h"
+#endif
+
+#ifdef STAGED_INIT_ENABLE
+#    include "staged_init.h"
+#endif
+
+#if defined(RGB_MATRIX_ENABLE) && defined(RGB_MATRIX_ADAPTIVE_SLICING)
+#    include "rgb_matrix.h"
+#endif
+
 static bool command_common(uint8_t code);
 static void command_common_help(void);
 static void print_version(void);
@@ -244,6 +260,19 @@ static void print_status(void) {
         , timer_read32()
 
     ); /* clang-format on */
+#ifdef PREDICTIVE_TAP_HOLD_ENABLE
+    predictive_tap_hold_print();
+#endif
+#ifdef TASK_SCHEDULER_ENABLE
+    task_scheduler_print();
+    task_scheduler_reset_stats();
+#endif
+#ifdef STAGED_INIT_ENABLE
+    staged_init_print();
+#endif
+#if defined(RGB_MATRIX_ENABLE) && defined(RGB_MATRIX_ADAPTIVE_SLICING)
+    rgb_matrix_print_stats();
+#endif
 }
 
 #if !defined(NO_PRINT) && !defined(USER_PRINT)
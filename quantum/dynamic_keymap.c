@@ -20,6 +20,7 @@
 #include "quantum.h" // for send_string()
 #include "dynamic_keymap.h"
 #include "via.h" // for default VIA_EEPROM_ADDR_END
+#include <string.h>
 
 #ifndef DYNAMIC_KEYMAP_LAYER_COUNT
 #    define DYNAMIC_KEYMAP_LAYER_COUNT 4
@@ -79,6 +80,23 @@
 #    define DYNAMIC_KEYMAP_MACRO_EEPROM_SIZE (DYNAMIC_KEYMAP_EEPROM_MAX_ADDR - DYNAMIC_KEYMAP_MACRO_EEPROM_ADDR + 1)
 #endif
 
+#define DYNAMIC_KEYMAP_EEPROM_SIZE (DYNAMIC_KEYMAP_LAYER_COUNT * MATRIX_ROWS * MATRIX_COLS * 2)
+
+#ifdef VIA_BULK_KEYMAP_ENABLE
+// RAM the decoded keymaps are staged in until the transfer is verified,
+// bulk writes are rejected if the keymaps do not fit
+#    ifndef DYNAMIC_KEYMAP_BULK_BUFFER_SIZE
+#        ifdef __AVR__
+#            define DYNAMIC_KEYMAP_BULK_BUFFER_SIZE 0
+#        else
+#            define DYNAMIC_KEYMAP_BULK_BUFFER_SIZE DYNAMIC_KEYMAP_EEPROM_SIZE
+#        endif
+#    endif
+#    if DYNAMIC_KEYMAP_BULK_BUFFER_SIZE >= DYNAMIC_KEYMAP_EEPROM_SIZE
+#        define DYNAMIC_KEYMAP_BULK_WRITE
+#    endif
+#endif
+
 uint8_t dynamic_keymap_get_layer_count(void) {
     return DYNAMIC_KEYMAP_LAYER_COUNT;
 }
@@ -116,33 +134,255 @@ void dynamic_keymap_reset(void) {
     }
 }
 
+// Number of bytes from offset that are inside the keymaps
+static uint16_t dynamic_keymap_buffer_span(uint16_t offset, uint16_t size) {
+    if (offset >= DYNAMIC_KEYMAP_EEPROM_SIZE) {
+        return 0;
+    }
+    uint16_t remaining = DYNAMIC_KEYMAP_EEPROM_SIZE - offset;
+    return size < remaining ? size : remaining;
+}
+
 void dynamic_keymap_get_buffer(uint16_t offset, uint16_t size, uint8_t *data) {
-    uint16_t dynamic_keymap_eeprom_size = DYNAMIC_KEYMAP_LAYER_COUNT * MATRIX_ROWS * MATRIX_COLS * 2;
-    void *   source                     = (void *)(DYNAMIC_KEYMAP_EEPROM_ADDR + offset);
-    uint8_t *target                     = data;
-    for (uint16_t i = 0; i < size; i++) {
-        if (offset + i < dynamic_keymap_eeprom_size) {
-            *target = eeprom_read_byte(source);
+    uint16_t span = dynamic_keymap_buffer_span(offset, size);
+    eeprom_read_block(data, (void *)(DYNAMIC_KEYMAP_EEPROM_ADDR + offset), span);
+    memset(data + span, 0x00, size - span);
+}
+
+void dynamic_keymap_set_buffer(uint16_t offset, uint16_t size, uint8_t *data) {
+    eeprom_update_block(data, (void *)(DYNAMIC_KEYMAP_EEPROM_ADDR + offset), dynamic_keymap_buffer_span(offset, size));
+}
+
+#ifdef VIA_BULK_KEYMAP_ENABLE
+/* Compressed keymap stream
+ *
+ * The keymaps are sent as big-endian keycodes, in the order of the EEPROM
+ * buffer, encoded as a sequence of tokens:
+ *   0x00-0x7F  n + 1 literal keycodes follow
+ *   0x80-0xBF  the following keycode, repeated n + 1 times
+ *   0xC0-0xFF  KC_TRANSPARENT, repeated n + 1 times
+ * Tokens may be split across packets.
+ */
+#    define BULK_LITERAL 0x00
+#    define BULK_REPEAT 0x80
+#    define BULK_TRANSPARENT 0xC0
+#    define BULK_KEYCODES (DYNAMIC_KEYMAP_EEPROM_SIZE / 2)
+
+// CRC-16/CCITT-FALSE
+static uint16_t crc16_update(uint16_t crc, uint8_t byte) {
+    crc ^= (uint16_t)byte << 8;
+    for (uint8_t i = 0; i < 8; i++) {
+        crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+    }
+    return crc;
+}
+
+static uint16_t bulk_read_keycode(uint16_t index) {
+    uint8_t bytes[2];
+    eeprom_read_block(bytes, (void *)(DYNAMIC_KEYMAP_EEPROM_ADDR + index * 2), 2);
+    return (bytes[0] << 8) | bytes[1];
+}
+
+uint16_t dynamic_keymap_get_buffer_size(void) {
+    return DYNAMIC_KEYMAP_EEPROM_SIZE;
+}
+
+uint16_t dynamic_keymap_get_buffer_crc(void) {
+    uint16_t crc = 0xFFFF;
+    uint8_t  chunk[32];
+    for (uint16_t offset = 0; offset < DYNAMIC_KEYMAP_EEPROM_SIZE; offset += sizeof(chunk)) {
+        uint16_t span = dynamic_keymap_buffer_span(offset, sizeof(chunk));
+        eeprom_read_block(chunk, (void *)(DYNAMIC_KEYMAP_EEPROM_ADDR + offset), span);
+        for (uint16_t i = 0; i < span; i++) {
+            crc = crc16_update(crc, chunk[i]);
+        }
+    }
+    return crc;
+}
+
+static struct {
+    uint16_t index;    // next keycode to encode
+    uint8_t  literals; // literal keycodes left in the current token
+    uint8_t  pending[3];
+    uint8_t  pending_len;
+    uint8_t  pending_pos;
+} encoder;
+
+void dynamic_keymap_encode_begin(void) {
+    memset(&encoder, 0, sizeof(encoder));
+}
+
+bool dynamic_keymap_encode_done(void) {
+    return encoder.index >= BULK_KEYCODES && encoder.pending_pos >= encoder.pending_len;
+}
+
+// Queues the next token, or the next keycode of a literal token
+static void bulk_encode_next(void) {
+    uint16_t keycode = bulk_read_keycode(encoder.index);
+
+    encoder.pending_pos = 0;
+    if (encoder.literals) {
+        encoder.pending[0]  = keycode >> 8;
+        encoder.pending[1]  = keycode & 0xFF;
+        encoder.pending_len = 2;
+        encoder.literals--;
+        encoder.index++;
+        return;
+    }
+
+    uint8_t repeat = 1;
+    while (repeat < 64 && encoder.index + repeat < BULK_KEYCODES && bulk_read_keycode(encoder.index + repeat) == keycode) {
+        repeat++;
+    }
+    if (keycode == KC_TRANSPARENT) {
+        encoder.pending[0]  = BULK_TRANSPARENT | (repeat - 1);
+        encoder.pending_len = 1;
+        encoder.index += repeat;
+    } else if (repeat > 1) {
+        encoder.pending[0]  = BULK_REPEAT | (repeat - 1);
+        encoder.pending[1]  = keycode >> 8;
+        encoder.pending[2]  = keycode & 0xFF;
+        encoder.pending_len = 3;
+        encoder.index += repeat;
+    } else {
+        // extend the literal up to the next run or transparent key
+        uint8_t  literals = 1;
+        uint16_t previous = keycode;
+        while (literals < 128 && encoder.index + literals < BULK_KEYCODES) {
+            uint16_t next = bulk_read_keycode(encoder.index + literals);
+            if (next == KC_TRANSPARENT || next == previous) {
+                if (next == previous) {
+                    literals--; // leave the first keycode of the run to it
+                }
+                break;
+            }
+            previous = next;
+            literals++;
+        }
+        encoder.pending[0]  = BULK_LITERAL | (literals - 1);
+        encoder.pending_len = 1;
+        encoder.literals    = literals;
+    }
+}
+
+uint8_t dynamic_keymap_encode(uint8_t *data, uint8_t size) {
+    uint8_t length = 0;
+    while (length < size) {
+        if (encoder.pending_pos >= encoder.pending_len) {
+            if (encoder.index >= BULK_KEYCODES) {
+                break;
+            }
+            bulk_encode_next();
+        }
+        data[length++] = encoder.pending[encoder.pending_pos++];
+    }
+    return length;
+}
+
+static struct {
+    uint16_t offset;   // next keymap byte to decode
+    uint16_t sequence; // next expected packet
+    uint16_t crc;
+    uint8_t  token; // current token, valid while count is non-zero
+    uint8_t  count; // keycodes left in the current token
+    uint8_t  repeated[2];
+    uint8_t  repeated_len;
+    uint8_t  status;
+#    ifdef DYNAMIC_KEYMAP_BULK_WRITE
+    uint8_t buffer[DYNAMIC_KEYMAP_EEPROM_SIZE];
+#    endif
+} decoder;
+
+void dynamic_keymap_decode_begin(void) {
+    decoder.offset       = 0;
+    decoder.sequence     = 0;
+    decoder.crc          = 0xFFFF;
+    decoder.count        = 0;
+    decoder.repeated_len = 0;
+#    ifdef DYNAMIC_KEYMAP_BULK_WRITE
+    decoder.status = DYNAMIC_KEYMAP_BULK_OK;
+#    else
+    decoder.status = DYNAMIC_KEYMAP_BULK_UNSUPPORTED;
+#    endif
+}
+
+static bool bulk_decode_byte(uint8_t byte) {
+    if (decoder.offset >= DYNAMIC_KEYMAP_EEPROM_SIZE) {
+        return false;
+    }
+#    ifdef DYNAMIC_KEYMAP_BULK_WRITE
+    decoder.buffer[decoder.offset] = byte;
+#    endif
+    decoder.offset++;
+    decoder.crc = crc16_update(decoder.crc, byte);
+    return true;
+}
+
+bool dynamic_keymap_decode(uint16_t sequence, const uint8_t *data, uint8_t size) {
+    if (decoder.status != DYNAMIC_KEYMAP_BULK_OK) {
+        return false;
+    }
+    if (sequence != decoder.sequence++) {
+        decoder.status = DYNAMIC_KEYMAP_BULK_SEQUENCE;
+        return false;
+    }
+
+    for (uint8_t i = 0; i < size; i++) {
+        uint8_t byte = data[i];
+        bool    ok   = true;
+
+        if (!decoder.count) {
+            decoder.token = byte;
+            decoder.count = (byte & 0x7F) + 1;
+            if ((byte & 0xC0) == BULK_TRANSPARENT) {
+                decoder.count = (byte & 0x3F) + 1;
+                while (ok && decoder.count) {
+                    ok = bulk_decode_byte(KC_TRANSPARENT >> 8) && bulk_decode_byte(KC_TRANSPARENT & 0xFF);
+                    decoder.count--;
+                }
+            } else if (byte & BULK_REPEAT) {
+                decoder.count        = (byte & 0x3F) + 1;
+                decoder.repeated_len = 0;
+            }
+        } else if (decoder.token & BULK_REPEAT) {
+            decoder.repeated[decoder.repeated_len++] = byte;
+            if (decoder.repeated_len == 2) {
+                while (ok && decoder.count) {
+                    ok = bulk_decode_byte(decoder.repeated[0]) && bulk_decode_byte(decoder.repeated[1]);
+                    decoder.count--;
+                }
+            }
         } else {
-            *target = 0x00;
+            ok = bulk_decode_byte(byte);
+            // a literal keycode is complete once its second byte is in
+            if (decoder.offset % 2 == 0) {
+                decoder.count--;
+            }
+        }
+
+        if (!ok) {
+            decoder.status = DYNAMIC_KEYMAP_BULK_LENGTH;
+            return false;
         }
-        source++;
-        target++;
     }
+    return true;
 }
 
-void dynamic_keymap_set_buffer(uint16_t offset, uint16_t size, uint8_t *data) {
-    uint16_t dynamic_keymap_eeprom_size = DYNAMIC_KEYMAP_LAYER_COUNT * MATRIX_ROWS * MATRIX_COLS * 2;
-    void *   target                     = (void *)(DYNAMIC_KEYMAP_EEPROM_ADDR + offset);
-    uint8_t *source                     = data;
-    for (uint16_t i = 0; i < size; i++) {
-        if (offset + i < dynamic_keymap_eeprom_size) {
-            eeprom_update_byte(target, *source);
+uint8_t dynamic_keymap_decode_end(uint16_t crc) {
+    if (decoder.status == DYNAMIC_KEYMAP_BULK_OK) {
+        if (decoder.offset != DYNAMIC_KEYMAP_EEPROM_SIZE || decoder.count) {
+            decoder.status = DYNAMIC_KEYMAP_BULK_LENGTH;
+        } else if (decoder.crc != crc) {
+            decoder.status = DYNAMIC_KEYMAP_BULK_CRC;
+        } else {
+#    ifdef DYNAMIC_KEYMAP_BULK_WRITE
+            eeprom_update_block(decoder.buffer, (void *)DYNAMIC_KEYMAP_EEPROM_ADDR, DYNAMIC_KEYMAP_EEPROM_SIZE);
+#    endif
         }
-        source++;
-        target++;
     }
+    return decoder.status;
 }
+#endif
 
 // This overrides the one in quantum/keymap_common.c
 uint16_t keymap_key_to_keycode(uint8_t layer, keypos_t key) {
@@ -161,6 +401,55 @@ uint16_t dynamic_keymap_macro_get_buffer_size(void) {
     return DYNAMIC_KEYMAP_MACRO_EEPROM_SIZE;
 }
 
+// RAM used to assemble a macro for send_string(), longer macros are sent in several parts
+#ifndef DYNAMIC_KEYMAP_MACRO_STAGING_SIZE
+#    define DYNAMIC_KEYMAP_MACRO_STAGING_SIZE 64
+#endif
+
+#define MACRO_OFFSET_NONE UINT16_MAX
+
+// Start of each macro in the buffer, plus the end of the last one.
+// Rebuilt on the first send after the buffer has been written.
+static uint16_t macro_offsets[DYNAMIC_KEYMAP_MACRO_COUNT + 1];
+static bool     macro_offsets_valid = false;
+
+static void dynamic_keymap_macro_index(void) {
+    uint8_t  chunk[32];
+    uint8_t  id     = 0;
+    uint16_t offset = 0;
+
+    macro_offsets[0] = 0;
+    for (uint8_t i = 1; i <= DYNAMIC_KEYMAP_MACRO_COUNT; i++) {
+        macro_offsets[i] = MACRO_OFFSET_NONE;
+    }
+
+    // Check the last byte of the buffer.
+    // If it's not zero, then we are in the middle
+    // of buffer writing, possibly an aborted buffer
+    // write. So no macro is usable.
+    if (eeprom_read_byte((void *)(DYNAMIC_KEYMAP_MACRO_EEPROM_ADDR + DYNAMIC_KEYMAP_MACRO_EEPROM_SIZE - 1)) != 0) {
+        macro_offsets[0] = MACRO_OFFSET_NONE;
+    } else {
+        // Each null character ends a macro. If there are fewer than
+        // DYNAMIC_KEYMAP_MACRO_COUNT, the buffer contents are garbage
+        // and the remaining macros are left unusable.
+        while (id < DYNAMIC_KEYMAP_MACRO_COUNT && offset < DYNAMIC_KEYMAP_MACRO_EEPROM_SIZE) {
+            uint16_t span = DYNAMIC_KEYMAP_MACRO_EEPROM_SIZE - offset;
+            if (span > sizeof(chunk)) {
+                span = sizeof(chunk);
+            }
+            eeprom_read_block(chunk, (void *)(DYNAMIC_KEYMAP_MACRO_EEPROM_ADDR + offset), span);
+            for (uint16_t i = 0; i < span && id < DYNAMIC_KEYMAP_MACRO_COUNT; i++) {
+                if (chunk[i] == 0) {
+                    macro_offsets[++id] = offset + i + 1;
+                }
+            }
+            offset += span;
+        }
+    }
+    macro_offsets_valid = true;
+}
+
 void dynamic_keymap_macro_get_buffer(uint16_t offset, uint16_t size, uint8_t *data) {
     void *   source = (void *)(DYNAMIC_KEYMAP_MACRO_EEPROM_ADDR + offset);
     uint8_t *target = data;
@@ -185,6 +474,7 @@ void dynamic_keymap_macro_set_buffer(uint16_t offset, uint16_t size, uint8_t *da
         source++;
         target++;
     }
+    macro_offsets_valid = false;
 }
 
 void dynamic_keymap_macro_reset(void) {
@@ -194,6 +484,7 @@ void dynamic_keymap_macro_reset(void) {
         eeprom_update_byte(p, 0);
         ++p;
     }
+    macro_offsets_valid = false;
 }
 
 void dynamic_keymap_macro_send(uint8_t id) {
@@ -201,54 +492,59 @@ void dynamic_keymap_macro_send(uint8_t id) {
         return;
     }
 
-    // Check the last byte of the buffer.
-    // If it's not zero, then we are in the middle
-    // of buffer writing, possibly an aborted buffer
-    // write. So do nothing.
-    void *p = (void *)(DYNAMIC_KEYMAP_MACRO_EEPROM_ADDR + DYNAMIC_KEYMAP_MACRO_EEPROM_SIZE - 1);
-    if (eeprom_read_byte(p) != 0) {
+    if (!macro_offsets_valid) {
+        dynamic_keymap_macro_index();
+    }
+    if (macro_offsets[id] == MACRO_OFFSET_NONE || macro_offsets[id + 1] == MACRO_OFFSET_NONE) {
         return;
     }
 
-    // Skip N null characters
-    // p will then point to the Nth macro
-    p         = (void *)(DYNAMIC_KEYMAP_MACRO_EEPROM_ADDR);
-    void *end = (void *)(DYNAMIC_KEYMAP_MACRO_EEPROM_ADDR + DYNAMIC_KEYMAP_MACRO_EEPROM_SIZE);
-    while (id > 0) {
-        // If we are past the end of the buffer, then the buffer
-        // contents are garbage, i.e. there were not DYNAMIC_KEYMAP_MACRO_COUNT
-        // nulls in the buffer.
-        if (p == end) {
-            return;
-        }
-        if (eeprom_read_byte(p) == 0) {
-            --id;
-        }
-        ++p;
-    }
+    // The macro is read a chunk at a time and expanded into the staging
+    // buffer, which is sent with a single send_string() unless it fills up.
+    // Magic chars (tap, down, up) are stored without SS_QMK_PREFIX
+    // and take the next char as the key to use.
+    char     staging[DYNAMIC_KEYMAP_MACRO_STAGING_SIZE + 1];
+    uint8_t  chunk[32];
+    uint16_t length = 0;
+    uint16_t offset = macro_offsets[id];
+    uint16_t end    = macro_offsets[id + 1] - 1; // without the null terminator
+    bool     magic  = false;
 
-    // Send the macro string one or three chars at a time
-    // by making temporary 1 or 3 char strings
-    char data[4] = {0, 0, 0, 0};
-    // We already checked there was a null at the end of
-    // the buffer, so this cannot go past the end
-    while (1) {
-        data[0] = eeprom_read_byte(p++);
-        data[1] = 0;
-        // Stop at the null terminator of this macro string
-        if (data[0] == 0) {
-            break;
+    while (offset < end) {
+        uint16_t span = end - offset;
+        if (span > sizeof(chunk)) {
+            span = sizeof(chunk);
         }
-        // If the char is magic (tap, down, up),
-        // add the next char (key to use) and send a 3 char string.
-        if (data[0] == SS_TAP_CODE || data[0] == SS_DOWN_CODE || data[0] == SS_UP_CODE) {
-            data[1] = data[0];
-            data[0] = SS_QMK_PREFIX;
-            data[2] = eeprom_read_byte(p++);
-            if (data[2] == 0) {
-                break;
+        eeprom_read_block(chunk, (void *)(DYNAMIC_KEYMAP_MACRO_EEPROM_ADDR + offset), span);
+        offset += span;
+
+        for (uint8_t i = 0; i < span; i++) {
+            uint8_t c = chunk[i];
+            if (magic) {
+                staging[length++] = c;
+                magic             = false;
+                continue;
+            }
+            // Keep room for a whole magic sequence
+            if (length + 3 > DYNAMIC_KEYMAP_MACRO_STAGING_SIZE) {
+                staging[length] = 0;
+                send_string(staging);
+                length = 0;
+            }
+            if (c == SS_TAP_CODE || c == SS_DOWN_CODE || c == SS_UP_CODE) {
+                staging[length++] = SS_QMK_PREFIX;
+                magic             = true;
             }
+            staging[length++] = c;
         }
-        send_string(data);
+    }
+
+    // A magic char without its key is dropped
+    if (magic) {
+        length -= 2;
+    }
+    if (length) {
+        staging[length] = 0;
+        send_string(staging);
     }
 }
@@ -34,6 +34,37 @@ void     dynamic_keymap_reset(void);
 void dynamic_keymap_get_buffer(uint16_t offset, uint16_t size, uint8_t *data);
 void dynamic_keymap_set_buffer(uint16_t offset, uint16_t size, uint8_t *data);
 
+#ifdef VIA_BULK_KEYMAP_ENABLE
+// Bulk transfer of the whole EEPROM buffer, in the compressed stream format
+// described in dynamic_keymap.c.
+// The CRC (CRC-16/CCITT-FALSE) covers the uncompressed buffer, so a host can
+// compare it to the keymap it is about to upload and skip unchanged uploads.
+uint16_t dynamic_keymap_get_buffer_size(void);
+uint16_t dynamic_keymap_get_buffer_crc(void);
+
+// Fills data with up to size bytes of the stream, returns the number written.
+void    dynamic_keymap_encode_begin(void);
+uint8_t dynamic_keymap_encode(uint8_t *data, uint8_t size);
+bool    dynamic_keymap_encode_done(void);
+
+// Packets must arrive in sequence, starting at 0. The decoded keymaps are
+// staged in RAM and written to EEPROM in one go by dynamic_keymap_decode_end(),
+// once the length and CRC have been verified. Writes are rejected if the
+// keymaps do not fit in DYNAMIC_KEYMAP_BULK_BUFFER_SIZE, so a failed transfer
+// never leaves the keymaps partially updated.
+enum dynamic_keymap_bulk_status {
+    DYNAMIC_KEYMAP_BULK_OK = 0,
+    DYNAMIC_KEYMAP_BULK_SEQUENCE,    // a packet was lost or out of order
+    DYNAMIC_KEYMAP_BULK_LENGTH,      // the stream does not decode to the size of the keymaps
+    DYNAMIC_KEYMAP_BULK_CRC,         // the CRC of the decoded keymaps does not match
+    DYNAMIC_KEYMAP_BULK_UNSUPPORTED, // the keymaps do not fit in DYNAMIC_KEYMAP_BULK_BUFFER_SIZE
+};
+
+void    dynamic_keymap_decode_begin(void);
+bool    dynamic_keymap_decode(uint16_t sequence, const uint8_t *data, uint8_t size);
+uint8_t dynamic_keymap_decode_end(uint16_t crc);
+#endif
+
 // This overrides the one in quantum/keymap_common.c
 // uint16_t keymap_key_to_keycode(uint8_t layer, keypos_t key);
 
@@ -0,0 +1,159 @@
+/* Copyright 2022 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "gtest/gtest.h"
+#include <vector>
+
+extern "C" {
+#include "dynamic_keymap.h"
+#include "eeprom.h"
+#include "keycode.h"
+}
+
+#define KEYMAP_SIZE (DYNAMIC_KEYMAP_LAYER_COUNT * MATRIX_ROWS * MATRIX_COLS * 2)
+#define PACKET_SIZE 28
+
+class DynamicKeymapBulk : public ::testing::Test {
+   protected:
+    std::vector<uint8_t> keymap;
+
+    void SetUp() override {
+        // a base layer of distinct keys, a layer with a run and the rest transparent
+        const uint16_t layers[DYNAMIC_KEYMAP_LAYER_COUNT][MATRIX_ROWS * MATRIX_COLS] = {
+            {KC_A, KC_B, KC_C, KC_D, KC_E, KC_F, KC_G, KC_H},
+            {KC_1, KC_1, KC_1, KC_1, KC_TRNS, KC_TRNS, KC_2, KC_3},
+        };
+        for (uint8_t layer = 0; layer < DYNAMIC_KEYMAP_LAYER_COUNT; layer++) {
+            for (uint8_t key = 0; key < MATRIX_ROWS * MATRIX_COLS; key++) {
+                uint16_t keycode = layer < 2 ? layers[layer][key] : KC_TRNS;
+                keymap.push_back(keycode >> 8);
+                keymap.push_back(keycode & 0xFF);
+            }
+        }
+        dynamic_keymap_set_buffer(0, keymap.size(), keymap.data());
+    }
+
+    std::vector<uint8_t> read_keymap() {
+        std::vector<uint8_t> data(KEYMAP_SIZE);
+        dynamic_keymap_get_buffer(0, data.size(), data.data());
+        return data;
+    }
+
+    void clear_keymap() {
+        std::vector<uint8_t> zeros(KEYMAP_SIZE, 0);
+        dynamic_keymap_set_buffer(0, zeros.size(), zeros.data());
+    }
+
+    std::vector<std::vector<uint8_t>> encode(uint8_t packet_size = PACKET_SIZE) {
+        std::vector<std::vector<uint8_t>> packets;
+        dynamic_keymap_encode_begin();
+        while (!dynamic_keymap_encode_done()) {
+            std::vector<uint8_t> packet(packet_size);
+            packet.resize(dynamic_keymap_encode(packet.data(), packet_size));
+            packets.push_back(packet);
+        }
+        return packets;
+    }
+};
+
+TEST_F(DynamicKeymapBulk, TransparentLayersCompress) {
+    auto   packets = encode();
+    size_t size    = 0;
+    for (auto &packet : packets) {
+        size += packet.size();
+    }
+    EXPECT_LT(size, KEYMAP_SIZE / 2);
+}
+
+#ifndef DYNAMIC_KEYMAP_TESTS_UNSTAGED
+TEST_F(DynamicKeymapBulk, RoundTrip) {
+    uint16_t crc = dynamic_keymap_get_buffer_crc();
+
+    // small packets split the tokens across packets
+    for (uint8_t packet_size : {3, PACKET_SIZE}) {
+        auto packets = encode(packet_size);
+
+        clear_keymap();
+        EXPECT_NE(dynamic_keymap_get_buffer_crc(), crc);
+
+        dynamic_keymap_decode_begin();
+        for (uint16_t i = 0; i < packets.size(); i++) {
+            EXPECT_TRUE(dynamic_keymap_decode(i, packets[i].data(), packets[i].size()));
+        }
+        EXPECT_EQ(dynamic_keymap_decode_end(crc), DYNAMIC_KEYMAP_BULK_OK);
+        EXPECT_EQ(read_keymap(), keymap);
+    }
+}
+
+TEST_F(DynamicKeymapBulk, CrcMismatchLeavesKeymapUntouched) {
+    uint16_t crc     = dynamic_keymap_get_buffer_crc();
+    auto     packets = encode();
+
+    clear_keymap();
+    auto cleared = read_keymap();
+
+    dynamic_keymap_decode_begin();
+    for (uint16_t i = 0; i < packets.size(); i++) {
+        dynamic_keymap_decode(i, packets[i].data(), packets[i].size());
+    }
+    EXPECT_EQ(dynamic_keymap_decode_end(crc ^ 1), DYNAMIC_KEYMAP_BULK_CRC);
+    EXPECT_EQ(read_keymap(), cleared);
+}
+
+TEST_F(DynamicKeymapBulk, LostPacketIsRejected) {
+    uint16_t crc     = dynamic_keymap_get_buffer_crc();
+    auto     packets = encode(4);
+    ASSERT_GT(packets.size(), 2);
+
+    clear_keymap();
+    auto cleared = read_keymap();
+
+    dynamic_keymap_decode_begin();
+    EXPECT_TRUE(dynamic_keymap_decode(0, packets[0].data(), packets[0].size()));
+    EXPECT_FALSE(dynamic_keymap_decode(2, packets[1].data(), packets[1].size()));
+    EXPECT_EQ(dynamic_keymap_decode_end(crc), DYNAMIC_KEYMAP_BULK_SEQUENCE);
+    EXPECT_EQ(read_keymap(), cleared);
+}
+
+TEST_F(DynamicKeymapBulk, ShortStreamIsRejected) {
+    uint16_t crc     = dynamic_keymap_get_buffer_crc();
+    auto     packets = encode(4);
+
+    clear_keymap();
+    auto cleared = read_keymap();
+
+    dynamic_keymap_decode_begin();
+    for (uint16_t i = 0; i + 1 < packets.size(); i++) {
+        dynamic_keymap_decode(i, packets[i].data(), packets[i].size());
+    }
+    EXPECT_EQ(dynamic_keymap_decode_end(crc), DYNAMIC_KEYMAP_BULK_LENGTH);
+    EXPECT_EQ(read_keymap(), cleared);
+}
+#else
+TEST_F(DynamicKeymapBulk, WritesAreRejectedWithoutStaging) {
+    uint16_t crc     = dynamic_keymap_get_buffer_crc();
+    auto     packets = encode();
+
+    clear_keymap();
+    auto cleared = read_keymap();
+
+    dynamic_keymap_decode_begin();
+    EXPECT_FALSE(dynamic_keymap_decode(0, packets[0].data(), packets[0].size()));
+    EXPECT_EQ(dynamic_keymap_decode_end(crc), DYNAMIC_KEYMAP_BULK_UNSUPPORTED);
+    EXPECT_EQ(read_keymap(), cleared);
+}
+#endif
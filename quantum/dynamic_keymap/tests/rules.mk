@@ -0,0 +1,20 @@
+# EEPROM addresses are cast from integers narrower than a host pointer
+dynamic_keymap_DEFS := \
+	-Wno-int-to-pointer-cast \
+	-DEEPROM_CUSTOM \
+	-DEEPROM_SIZE=512 \
+	-DVIA_BULK_KEYMAP_ENABLE \
+	-DDYNAMIC_KEYMAP_LAYER_COUNT=4 \
+	-DMATRIX_ROWS=2 \
+	-DMATRIX_COLS=4 \
+	-DDYNAMIC_KEYMAP_EEPROM_ADDR=32
+
+dynamic_keymap_SRC := \
+	$(QUANTUM_PATH)/dynamic_keymap/tests/mock.c \
+	$(QUANTUM_PATH)/dynamic_keymap/tests/dynamic_keymap_tests.cpp \
+	$(QUANTUM_PATH)/dynamic_keymap.c \
+	$(PLATFORM_PATH)/$(PLATFORM_KEY)/eeprom.c
+
+dynamic_keymap_unstaged_DEFS := $(dynamic_keymap_DEFS) -DDYNAMIC_KEYMAP_BULK_BUFFER_SIZE=0 -DDYNAMIC_KEYMAP_TESTS_UNSTAGED
+
+dynamic_keymap_unstaged_SRC := $(dynamic_keymap_SRC)
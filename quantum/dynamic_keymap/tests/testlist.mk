@@ -0,0 +1,3 @@
+TEST_LIST += \
+	dynamic_keymap \
+	dynamic_keymap_unstaged
@@ -1,8 +1,10 @@
 #include <stdint.h>
 #include <stdbool.h>
+#include <string.h>
 #include "eeprom.h"
 #include "eeconfig.h"
 #include "action_layer.h"
+#include "timer.h"
 
 #if defined(EEPROM_DRIVER)
 #    include "eeprom_driver.h"
@@ -13,11 +15,202 @@
 #endif
 
 #if defined(VIA_ENABLE)
+#    include "via.h"
 bool via_eeprom_is_valid(void);
 void via_eeprom_set_valid(bool valid);
 void eeconfig_init_via(void);
 #endif
 
+/* Layout of the cached area, one field per EECONFIG_* address. The magic
+ * number doubles as its version, see EECONFIG_MAGIC_NUMBER.
+ */
+typedef struct __attribute__((packed)) {
+    uint16_t magic;
+    uint8_t  debug;
+    uint8_t  default_layer;
+    uint8_t  keymap_lower;
+    uint8_t  mousekey_accel;
+    uint8_t  backlight;
+    uint8_t  audio;
+    uint32_t rgblight;
+    uint8_t  unicode_mode;
+    uint8_t  steno_mode;
+    uint8_t  handedness;
+    uint32_t keyboard;
+    uint32_t user;
+    uint8_t  velocikey;
+    uint32_t haptic;
+    uint32_t led_matrix; // or rgb_matrix
+    uint16_t led_matrix_extended;
+    uint8_t  keymap_upper;
+#if defined(VIA_ENABLE) && (VIA_EEPROM_MAGIC_ADDR == EECONFIG_SIZE)
+    // VIA keeps its magic and layout options right behind
+    uint8_t via_magic[3];
+    uint8_t via_layout_options[VIA_EEPROM_LAYOUT_OPTIONS_SIZE];
+#endif
+} eeconfig_t;
+
+#define EECONFIG_ASSERT_FIELD(field, addr) _Static_assert(offsetof(eeconfig_t, field) == (uintptr_t)(addr), "eeconfig_t does not match " #addr)
+EECONFIG_ASSERT_FIELD(magic, EECONFIG_MAGIC);
+EECONFIG_ASSERT_FIELD(debug, EECONFIG_DEBUG);
+EECONFIG_ASSERT_FIELD(default_layer, EECONFIG_DEFAULT_LAYER);
+EECONFIG_ASSERT_FIELD(keymap_lower, EECONFIG_KEYMAP_LOWER_BYTE);
+EECONFIG_ASSERT_FIELD(mousekey_accel, EECONFIG_MOUSEKEY_ACCEL);
+EECONFIG_ASSERT_FIELD(backlight, EECONFIG_BACKLIGHT);
+EECONFIG_ASSERT_FIELD(audio, EECONFIG_AUDIO);
+EECONFIG_ASSERT_FIELD(rgblight, EECONFIG_RGBLIGHT);
+EECONFIG_ASSERT_FIELD(unicode_mode, EECONFIG_UNICODEMODE);
+EECONFIG_ASSERT_FIELD(steno_mode, EECONFIG_STENOMODE);
+EECONFIG_ASSERT_FIELD(handedness, EECONFIG_HANDEDNESS);
+EECONFIG_ASSERT_FIELD(keyboard, EECONFIG_KEYBOARD);
+EECONFIG_ASSERT_FIELD(user, EECONFIG_USER);
+EECONFIG_ASSERT_FIELD(velocikey, EECONFIG_VELOCIKEY);
+EECONFIG_ASSERT_FIELD(haptic, EECONFIG_HAPTIC);
+EECONFIG_ASSERT_FIELD(led_matrix, EECONFIG_LED_MATRIX);
+EECONFIG_ASSERT_FIELD(led_matrix_extended, EECONFIG_LED_MATRIX_EXTENDED);
+EECONFIG_ASSERT_FIELD(keymap_upper, EECONFIG_KEYMAP_UPPER_BYTE);
+#if defined(VIA_ENABLE) && (VIA_EEPROM_MAGIC_ADDR == EECONFIG_SIZE)
+EECONFIG_ASSERT_FIELD(via_magic, VIA_EEPROM_MAGIC_ADDR);
+EECONFIG_ASSERT_FIELD(via_layout_options, VIA_EEPROM_LAYOUT_OPTIONS_ADDR);
+#else
+_Static_assert(sizeof(eeconfig_t) == EECONFIG_SIZE, "eeconfig_t does not cover EECONFIG_SIZE");
+#endif
+
+static union {
+    eeconfig_t config;
+    uint8_t    raw[sizeof(eeconfig_t)];
+} eeconfig_cache;
+
+static bool     eeconfig_loaded = false;
+static uint8_t  eeconfig_dirty[(sizeof(eeconfig_t) + 7) / 8];
+static bool     eeconfig_pending = false;
+static uint16_t eeconfig_timer   = 0;
+
+/** \brief Fills the cache with one block read
+ *
+ * Also used after the EEPROM was erased, pending changes are dropped.
+ */
+static void eeconfig_load(void) {
+    eeprom_read_block(eeconfig_cache.raw, (const void *)0, sizeof(eeconfig_cache.raw));
+    memset(eeconfig_dirty, 0, sizeof(eeconfig_dirty));
+    eeconfig_pending = false;
+    eeconfig_loaded  = true;
+}
+
+/* number of bytes at the start of [offset, offset + len) that are cached */
+static size_t eeconfig_cached_length(uintptr_t offset, size_t len) {
+    if (offset >= sizeof(eeconfig_cache.raw)) {
+        return 0;
+    }
+    size_t cached = sizeof(eeconfig_cache.raw) - offset;
+    return cached < len ? cached : len;
+}
+
+/** \brief Reads from the cache, the EEPROM for anything past it
+ */
+void eeconfig_read_block(void *buf, const void *addr, size_t len) {
+    uintptr_t offset = (uintptr_t)addr;
+    size_t    cached = eeconfig_cached_length(offset, len);
+
+    if (cached) {
+        if (!eeconfig_loaded) {
+            eeconfig_load();
+        }
+        memcpy(buf, &eeconfig_cache.raw[offset], cached);
+    }
+    if (cached < len) {
+        eeprom_read_block((uint8_t *)buf + cached, (const uint8_t *)addr + cached, len - cached);
+    }
+}
+
+/** \brief Updates the cache and marks the changed bytes for eeconfig_task
+ */
+void eeconfig_update_block(const void *buf, void *addr, size_t len) {
+    uintptr_t offset = (uintptr_t)addr;
+    size_t    cached = eeconfig_cached_length(offset, len);
+
+    if (cached) {
+        if (!eeconfig_loaded) {
+            eeconfig_load();
+        }
+        const uint8_t *src = buf;
+        for (size_t i = 0; i < cached; i++) {
+            if (eeconfig_cache.raw[offset + i] != src[i]) {
+                eeconfig_cache.raw[offset + i] = src[i];
+                eeconfig_dirty[(offset + i) / 8] |= 1 << ((offset + i) % 8);
+                eeconfig_pending = true;
+            }
+        }
+        eeconfig_timer = timer_read();
+#if EECONFIG_FLUSH_DELAY == 0
+        eeconfig_flush();
+#endif
+    }
+    if (cached < len) {
+        eeprom_update_block((const uint8_t *)buf + cached, (uint8_t *)addr + cached, len - cached);
+    }
+}
+
+uint8_t eeconfig_read_byte(const uint8_t *addr) {
+    uint8_t val;
+    eeconfig_read_block(&val, addr, sizeof(val));
+    return val;
+}
+void eeconfig_update_byte(uint8_t *addr, uint8_t val) {
+    eeconfig_update_block(&val, addr, sizeof(val));
+}
+
+uint16_t eeconfig_read_word(const uint16_t *addr) {
+    uint16_t val;
+    eeconfig_read_block(&val, addr, sizeof(val));
+    return val;
+}
+void eeconfig_update_word(uint16_t *addr, uint16_t val) {
+    eeconfig_update_block(&val, addr, sizeof(val));
+}
+
+uint32_t eeconfig_read_dword(const uint32_t *addr) {
+    uint32_t val;
+    eeconfig_read_block(&val, addr, sizeof(val));
+    return val;
+}
+void eeconfig_update_dword(uint32_t *addr, uint32_t val) {
+    eeconfig_update_block(&val, addr, sizeof(val));
+}
+
+/** \brief Writes all changed bytes back to the EEPROM
+ *
+ * Consecutive dirty bytes go out as one block write.
+ */
+void eeconfig_flush(void) {
+    if (!eeconfig_pending) {
+        return;
+    }
+    uint8_t start = 0;
+    while (start < sizeof(eeconfig_cache.raw)) {
+        if (!(eeconfig_dirty[start / 8] & (1 << (start % 8)))) {
+            start++;
+            continue;
+        }
+        uint8_t end = start;
+        while (end < sizeof(eeconfig_cache.raw) && (eeconfig_dirty[end / 8] & (1 << (end % 8)))) {
+            end++;
+        }
+        eeprom_update_block(&eeconfig_cache.raw[start], (void *)(uintptr_t)start, end - start);
+        start = end;
+    }
+    memset(eeconfig_dirty, 0, sizeof(eeconfig_dirty));
+    eeconfig_pending = false;
+}
+
+/** \brief Writes pending changes once they have settled
+ */
+void eeconfig_task(void) {
+    if (eeconfig_pending && timer_elapsed(eeconfig_timer) >= EECONFIG_FLUSH_DELAY) {
+        eeconfig_flush();
+    }
+}
+
 /** \brief eeconfig enable
  *
  * FIXME: needs doc
@@ -40,31 +233,32 @@ __attribute__((weak)) void eeconfig_init_kb(void) {
 void eeconfig_init_quantum(void) {
 #if defined(EEPROM_DRIVER)
     eeprom_driver_erase();
+    eeconfig_load();
 #endif
-    eeprom_update_word(EECONFIG_MAGIC, EECONFIG_MAGIC_NUMBER);
-    eeprom_update_byte(EECONFIG_DEBUG, 0);
-    eeprom_update_byte(EECONFIG_DEFAULT_LAYER, 0);
+    eeconfig_update_word(EECONFIG_MAGIC, EECONFIG_MAGIC_NUMBER);
+    eeconfig_update_byte(EECONFIG_DEBUG, 0);
+    eeconfig_update_byte(EECONFIG_DEFAULT_LAYER, 0);
     default_layer_state = 0;
-    eeprom_update_byte(EECONFIG_KEYMAP_LOWER_BYTE, 0);
-    eeprom_update_byte(EECONFIG_KEYMAP_UPPER_BYTE, 0);
-    eeprom_update_byte(EECONFIG_MOUSEKEY_ACCEL, 0);
-    eeprom_update_byte(EECONFIG_BACKLIGHT, 0);
-    eeprom_update_byte(EECONFIG_AUDIO, 0xFF); // On by default
-    eeprom_update_dword(EECONFIG_RGBLIGHT, 0);
-    eeprom_update_byte(EECONFIG_STENOMODE, 0);
-    eeprom_update_dword(EECONFIG_HAPTIC, 0);
-    eeprom_update_byte(EECONFIG_VELOCIKEY, 0);
-    eeprom_update_dword(EECONFIG_RGB_MATRIX, 0);
-    eeprom_update_word(EECONFIG_RGB_MATRIX_EXTENDED, 0);
+    eeconfig_update_byte(EECONFIG_KEYMAP_LOWER_BYTE, 0);
+    eeconfig_update_byte(EECONFIG_KEYMAP_UPPER_BYTE, 0);
+    eeconfig_update_byte(EECONFIG_MOUSEKEY_ACCEL, 0);
+    eeconfig_update_byte(EECONFIG_BACKLIGHT, 0);
+    eeconfig_update_byte(EECONFIG_AUDIO, 0xFF); // On by default
+    eeconfig_update_dword(EECONFIG_RGBLIGHT, 0);
+    eeconfig_update_byte(EECONFIG_STENOMODE, 0);
+    eeconfig_update_dword(EECONFIG_HAPTIC, 0);
+    eeconfig_update_byte(EECONFIG_VELOCIKEY, 0);
+    eeconfig_update_dword(EECONFIG_RGB_MATRIX, 0);
+    eeconfig_update_word(EECONFIG_RGB_MATRIX_EXTENDED, 0);
 
     // TODO: Remove once ARM has a way to configure EECONFIG_HANDEDNESS
     //        within the emulated eeprom via dfu-util or another tool
 #if defined INIT_EE_HANDS_LEFT
 #    pragma message "Faking EE_HANDS for left hand"
-    eeprom_update_byte(EECONFIG_HANDEDNESS, 1);
+    eeconfig_update_byte(EECONFIG_HANDEDNESS, 1);
 #elif defined INIT_EE_HANDS_RIGHT
 #    pragma message "Faking EE_HANDS for right hand"
-    eeprom_update_byte(EECONFIG_HANDEDNESS, 0);
+    eeconfig_update_byte(EECONFIG_HANDEDNESS, 0);
 #endif
 
 #if defined(HAPTIC_ENABLE)
@@ -73,7 +267,7 @@ void eeconfig_init_quantum(void) {
     // this is used in case haptic is disabled, but we still want sane defaults
     // in the haptic configuration eeprom. All zero will trigger a haptic_reset
     // when a haptic-enabled firmware is loaded onto the keyboard.
-    eeprom_update_dword(EECONFIG_HAPTIC, 0);
+    eeconfig_update_dword(EECONFIG_HAPTIC, 0);
 #endif
 #if defined(VIA_ENABLE)
     // Invalidate VIA eeprom config, and then reset.
@@ -84,6 +278,7 @@ void eeconfig_init_quantum(void) {
 #endif
 
     eeconfig_init_kb();
+    eeconfig_flush();
 }
 
 /** \brief eeconfig initialization
@@ -99,7 +294,8 @@ void eeconfig_init(void) {
  * FIXME: needs doc
  */
 void eeconfig_enable(void) {
-    eeprom_update_word(EECONFIG_MAGIC, EECONFIG_MAGIC_NUMBER);
+    eeconfig_update_word(EECONFIG_MAGIC, EECONFIG_MAGIC_NUMBER);
+    eeconfig_flush();
 }
 
 /** \brief eeconfig disable
@@ -109,8 +305,10 @@ void eeconfig_enable(void) {
 void eeconfig_disable(void) {
 #if defined(EEPROM_DRIVER)
     eeprom_driver_erase();
+    eeconfig_load();
 #endif
-    eeprom_update_word(EECONFIG_MAGIC, EECONFIG_MAGIC_NUMBER_OFF);
+    eeconfig_update_word(EECONFIG_MAGIC, EECONFIG_MAGIC_NUMBER_OFF);
+    eeconfig_flush();
 }
 
 /** \brief eeconfig is enabled
@@ -118,7 +316,7 @@ void eeconfig_disable(void) {
  * FIXME: needs doc
  */
 bool eeconfig_is_enabled(void) {
-    bool is_eeprom_enabled = (eeprom_read_word(EECONFIG_MAGIC) == EECONFIG_MAGIC_NUMBER);
+    bool is_eeprom_enabled = (eeconfig_read_word(EECONFIG_MAGIC) == EECONFIG_MAGIC_NUMBER);
 #ifdef VIA_ENABLE
     if (is_eeprom_enabled) {
         is_eeprom_enabled = via_eeprom_is_valid();
@@ -132,7 +330,7 @@ bool eeconfig_is_enabled(void) {
  * FIXME: needs doc
  */
 bool eeconfig_is_disabled(void) {
-    bool is_eeprom_disabled = (eeprom_read_word(EECONFIG_MAGIC) == EECONFIG_MAGIC_NUMBER_OFF);
+    bool is_eeprom_disabled = (eeconfig_read_word(EECONFIG_MAGIC) == EECONFIG_MAGIC_NUMBER_OFF);
 #ifdef VIA_ENABLE
     if (!is_eeprom_disabled) {
         is_eeprom_disabled = !via_eeprom_is_valid();
@@ -146,14 +344,14 @@ bool eeconfig_is_disabled(void) {
  * FIXME: needs doc
  */
 uint8_t eeconfig_read_debug(void) {
-    return eeprom_read_byte(EECONFIG_DEBUG);
+    return eeconfig_read_byte(EECONFIG_DEBUG);
 }
 /** \brief eeconfig update debug
  *
  * FIXME: needs doc
  */
 void eeconfig_update_debug(uint8_t val) {
-    eeprom_update_byte(EECONFIG_DEBUG, val);
+    eeconfig_update_byte(EECONFIG_DEBUG, val);
 }
 
 /** \brief eeconfig read default layer
@@ -161,14 +359,14 @@ void eeconfig_update_debug(uint8_t val) {
  * FIXME: needs doc
  */
 uint8_t eeconfig_read_default_layer(void) {
-    return eeprom_read_byte(EECONFIG_DEFAULT_LAYER);
+    return eeconfig_read_byte(EECONFIG_DEFAULT_LAYER);
 }
 /** \brief eeconfig update default layer
  *
  * FIXME: needs doc
  */
 void eeconfig_update_default_layer(uint8_t val) {
-    eeprom_update_byte(EECONFIG_DEFAULT_LAYER, val);
+    eeconfig_update_byte(EECONFIG_DEFAULT_LAYER, val);
 }
 
 /** \brief eeconfig read keymap
@@ -176,15 +374,15 @@ void eeconfig_update_default_layer(uint8_t val) {
  * FIXME: needs doc
  */
 uint16_t eeconfig_read_keymap(void) {
-    return (eeprom_read_byte(EECONFIG_KEYMAP_LOWER_BYTE) | (eeprom_read_byte(EECONFIG_KEYMAP_UPPER_BYTE) << 8));
+    return (eeconfig_read_byte(EECONFIG_KEYMAP_LOWER_BYTE) | (eeconfig_read_byte(EECONFIG_KEYMAP_UPPER_BYTE) << 8));
 }
 /** \brief eeconfig update keymap
  *
  * FIXME: needs doc
  */
 void eeconfig_update_keymap(uint16_t val) {
-    eeprom_update_byte(EECONFIG_KEYMAP_LOWER_BYTE, val & 0xFF);
-    eeprom_update_byte(EECONFIG_KEYMAP_UPPER_BYTE, (val >> 8) & 0xFF);
+    eeconfig_update_byte(EECONFIG_KEYMAP_LOWER_BYTE, val & 0xFF);
+    eeconfig_update_byte(EECONFIG_KEYMAP_UPPER_BYTE, (val >> 8) & 0xFF);
 }
 
 /** \brief eeconfig read audio
@@ -192,14 +390,14 @@ void eeconfig_update_keymap(uint16_t val) {
  * FIXME: needs doc
  */
 uint8_t eeconfig_read_audio(void) {
-    return eeprom_read_byte(EECONFIG_AUDIO);
+    return eeconfig_read_byte(EECONFIG_AUDIO);
 }
 /** \brief eeconfig update audio
  *
  * FIXME: needs doc
  */
 void eeconfig_update_audio(uint8_t val) {
-    eeprom_update_byte(EECONFIG_AUDIO, val);
+    eeconfig_update_byte(EECONFIG_AUDIO, val);
 }
 
 /** \brief eeconfig read kb
@@ -207,14 +405,14 @@ void eeconfig_update_audio(uint8_t val) {
  * FIXME: needs doc
  */
 uint32_t eeconfig_read_kb(void) {
-    return eeprom_read_dword(EECONFIG_KEYBOARD);
+    return eeconfig_read_dword(EECONFIG_KEYBOARD);
 }
 /** \brief eeconfig update kb
  *
  * FIXME: needs doc
  */
 void eeconfig_update_kb(uint32_t val) {
-    eeprom_update_dword(EECONFIG_KEYBOARD, val);
+    eeconfig_update_dword(EECONFIG_KEYBOARD, val);
 }
 
 /** \brief eeconfig read user
@@ -222,14 +420,14 @@ void eeconfig_update_kb(uint32_t val) {
  * FIXME: needs doc
  */
 uint32_t eeconfig_read_user(void) {
-    return eeprom_read_dword(EECONFIG_USER);
+    return eeconfig_read_dword(EECONFIG_USER);
 }
 /** \brief eeconfig update user
  *
  * FIXME: needs doc
  */
 void eeconfig_update_user(uint32_t val) {
-    eeprom_update_dword(EECONFIG_USER, val);
+    eeconfig_update_dword(EECONFIG_USER, val);
 }
 
 /** \brief eeconfig read haptic
@@ -237,14 +435,14 @@ void eeconfig_update_user(uint32_t val) {
  * FIXME: needs doc
  */
 uint32_t eeconfig_read_haptic(void) {
-    return eeprom_read_dword(EECONFIG_HAPTIC);
+    return eeconfig_read_dword(EECONFIG_HAPTIC);
 }
 /** \brief eeconfig update haptic
  *
  * FIXME: needs doc
  */
 void eeconfig_update_haptic(uint32_t val) {
-    eeprom_update_dword(EECONFIG_HAPTIC, val);
+    eeconfig_update_dword(EECONFIG_HAPTIC, val);
 }
 
 /** \brief eeconfig read split handedness
@@ -252,12 +450,12 @@ void eeconfig_update_haptic(uint32_t val) {
  * FIXME: needs doc
  */
 bool eeconfig_read_handedness(void) {
-    return !!eeprom_read_byte(EECONFIG_HANDEDNESS);
+    return !!eeconfig_read_byte(EECONFIG_HANDEDNESS);
 }
 /** \brief eeconfig update split handedness
  *
  * FIXME: needs doc
  */
 void eeconfig_update_handedness(bool val) {
-    eeprom_update_byte(EECONFIG_HANDEDNESS, !!val);
+    eeconfig_update_byte(EECONFIG_HANDEDNESS, !!val);
 }
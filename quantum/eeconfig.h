@@ -19,12 +19,18 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <stddef.h>
 
 #ifndef EECONFIG_MAGIC_NUMBER
 #    define EECONFIG_MAGIC_NUMBER (uint16_t)0xFEE9 // When changing, decrement this value to avoid future re-init issues
 #endif
 #define EECONFIG_MAGIC_NUMBER_OFF (uint16_t)0xFFFF
 
+/* time without further changes before cached settings are written back (ms), 0 writes through */
+#ifndef EECONFIG_FLUSH_DELAY
+#    define EECONFIG_FLUSH_DELAY 1000
+#endif
+
 /* EEPROM parameter address */
 #define EECONFIG_MAGIC (uint16_t *)0
 #define EECONFIG_DEBUG (uint8_t *)2
@@ -73,6 +79,22 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #define EECONFIG_KEYMAP_LOWER_BYTE EECONFIG_KEYMAP
 
+/* Access to the EECONFIG area goes through a RAM copy, loaded with a single
+ * block read on first use. Updates only mark bytes dirty, eeconfig_task()
+ * writes them back once nothing changed for EECONFIG_FLUSH_DELAY.
+ * Addresses past the cached area are passed through to the EEPROM.
+ */
+void     eeconfig_read_block(void *buf, const void *addr, size_t len);
+void     eeconfig_update_block(const void *buf, void *addr, size_t len);
+uint8_t  eeconfig_read_byte(const uint8_t *addr);
+void     eeconfig_update_byte(uint8_t *addr, uint8_t val);
+uint16_t eeconfig_read_word(const uint16_t *addr);
+void     eeconfig_update_word(uint16_t *addr, uint16_t val);
+uint32_t eeconfig_read_dword(const uint32_t *addr);
+void     eeconfig_update_dword(uint32_t *addr, uint32_t val);
+void     eeconfig_flush(void);
+void     eeconfig_task(void);
+
 bool eeconfig_is_enabled(void);
 bool eeconfig_is_disabled(void);
 
@@ -116,12 +138,12 @@ void eeconfig_update_handedness(bool val);
     static uint8_t dirty_##name = false;                                \
                                                                         \
     static inline void eeconfig_init_##name(void) {                     \
-        eeprom_read_block(&config, offset, sizeof(config));             \
+        eeconfig_read_block(&config, offset, sizeof(config));           \
         dirty_##name = false;                                           \
     }                                                                   \
     static inline void eeconfig_flush_##name(bool force) {              \
         if (force || dirty_##name) {                                    \
-            eeprom_update_block(&config, offset, sizeof(config));       \
+            eeconfig_update_block(&config, offset, sizeof(config));     \
             dirty_##name = false;                                       \
         }                                                               \
     }                                                                   \
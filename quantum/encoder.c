@@ -47,8 +47,39 @@ static uint8_t encoder_resolutions[] = ENCODER_RESOLUTIONS;
 #endif
 static int8_t encoder_LUT[] = {0, -1, 1, 0, 1, 0, 0, -1, -1, 0, 0, 1, 0, 1, -1, 0};
 
-static uint8_t encoder_state[NUMBER_OF_ENCODERS]  = {0};
-static int8_t  encoder_pulses[NUMBER_OF_ENCODERS] = {0};
+#if defined(ENCODER_TIMERS) || defined(ENCODER_INTERRUPT)
+#    ifndef PROTOCOL_CHIBIOS
+#        error "ENCODER_TIMERS and ENCODER_INTERRUPT are only supported on ChibiOS"
+#    endif
+#    if defined(ENCODER_INTERRUPT) && !PAL_USE_CALLBACKS
+#        error "ENCODER_INTERRUPT requires PAL_USE_CALLBACKS to be TRUE in halconf.h"
+#    endif
+#    if defined(ENCODER_TIMERS) && defined(SPLIT_KEYBOARD) && defined(ENCODERS_PAD_A_RIGHT)
+#        error "ENCODER_TIMERS cannot be used with different encoder pins on the right half"
+#    endif
+#endif
+
+#ifdef ENCODER_TIMERS
+#    ifndef ENCODER_TIMER_PAL_MODE
+#        define ENCODER_TIMER_PAL_MODE 2
+#    endif
+#    ifndef ENCODER_TIMER_FILTER
+#        define ENCODER_TIMER_FILTER 4
+#    endif
+/* Timers running in encoder mode, with pad A on channel 1 and pad B on channel 2.
+ * Encoders without a timer (NULL) fall back to interrupts or polling.
+ */
+static stm32_tim_t *const encoder_timers[NUMBER_OF_ENCODERS]      = ENCODER_TIMERS;
+static uint16_t           encoder_timer_count[NUMBER_OF_ENCODERS] = {0};
+#endif
+
+#ifdef ENCODER_INTERRUPT
+static volatile uint8_t encoder_state[NUMBER_OF_ENCODERS]      = {0};
+static volatile int8_t  encoder_isr_pulses[NUMBER_OF_ENCODERS] = {0};
+#else
+static uint8_t encoder_state[NUMBER_OF_ENCODERS] = {0};
+#endif
+static int8_t encoder_pulses[NUMBER_OF_ENCODERS] = {0};
 
 #ifdef SPLIT_KEYBOARD
 // right half encoders come over as second set of encoders
@@ -71,6 +102,49 @@ __attribute__((weak)) bool encoder_update_kb(uint8_t index, bool clockwise) {
     return encoder_update_user(index, clockwise);
 }
 
+#ifdef ENCODER_TIMERS
+static void encoder_timer_init(stm32_tim_t *tim) {
+#    if STM32_HAS_TIM1
+    if (tim == STM32_TIM1) rccEnableTIM1(true);
+#    endif
+#    if STM32_HAS_TIM2
+    if (tim == STM32_TIM2) rccEnableTIM2(true);
+#    endif
+#    if STM32_HAS_TIM3
+    if (tim == STM32_TIM3) rccEnableTIM3(true);
+#    endif
+#    if STM32_HAS_TIM4
+    if (tim == STM32_TIM4) rccEnableTIM4(true);
+#    endif
+#    if STM32_HAS_TIM5
+    if (tim == STM32_TIM5) rccEnableTIM5(true);
+#    endif
+#    if STM32_HAS_TIM8
+    if (tim == STM32_TIM8) rccEnableTIM8(true);
+#    endif
+
+    // encoder mode 3: count on both edges of both inputs, the counter wraps at 16 bits
+    tim->CR1   = 0;
+    tim->SMCR  = STM32_TIM_SMCR_SMS(3);
+    tim->CCMR1 = STM32_TIM_CCMR1_CC1S(1) | STM32_TIM_CCMR1_IC1F(ENCODER_TIMER_FILTER) | STM32_TIM_CCMR1_CC2S(1) | STM32_TIM_CCMR1_IC2F(ENCODER_TIMER_FILTER);
+    tim->CCER  = 0;
+    tim->ARR   = 0xFFFF;
+    tim->CNT   = 0;
+    tim->CR1   = STM32_TIM_CR1_CEN;
+}
+#endif
+
+#ifdef ENCODER_INTERRUPT
+static void encoder_isr(void *arg) {
+    uint8_t i = (uintptr_t)arg;
+
+    chSysLockFromISR();
+    encoder_state[i] = (encoder_state[i] << 2) | (readPin(encoders_pad_a[i]) << 0) | (readPin(encoders_pad_b[i]) << 1);
+    encoder_isr_pulses[i] += encoder_LUT[encoder_state[i] & 0xF];
+    chSysUnlockFromISR();
+}
+#endif
+
 void encoder_init(void) {
 #if defined(SPLIT_KEYBOARD) && defined(ENCODERS_PAD_A_RIGHT) && defined(ENCODERS_PAD_B_RIGHT)
     if (!isLeftHand) {
@@ -98,41 +172,93 @@ void encoder_init(void) {
         encoder_state[i] = (readPin(encoders_pad_a[i]) << 0) | (readPin(encoders_pad_b[i]) << 1);
     }
 
+#if defined(ENCODER_TIMERS) || defined(ENCODER_INTERRUPT)
+    for (uint8_t i = 0; i < NUMBER_OF_ENCODERS; i++) {
+#    ifdef ENCODER_TIMERS
+        if (encoder_timers[i]) {
+            palSetLineMode(encoders_pad_a[i], PAL_MODE_ALTERNATE(ENCODER_TIMER_PAL_MODE) | PAL_STM32_PUPDR_PULLUP);
+            palSetLineMode(encoders_pad_b[i], PAL_MODE_ALTERNATE(ENCODER_TIMER_PAL_MODE) | PAL_STM32_PUPDR_PULLUP);
+            encoder_timer_init(encoder_timers[i]);
+            encoder_timer_count[i] = encoder_timers[i]->CNT;
+            continue;
+        }
+#    endif
+#    ifdef ENCODER_INTERRUPT
+        palEnableLineEvent(encoders_pad_a[i], PAL_EVENT_MODE_BOTH_EDGES);
+        palEnableLineEvent(encoders_pad_b[i], PAL_EVENT_MODE_BOTH_EDGES);
+        palSetLineCallback(encoders_pad_a[i], encoder_isr, (void *)(uintptr_t)i);
+        palSetLineCallback(encoders_pad_b[i], encoder_isr, (void *)(uintptr_t)i);
+#    endif
+    }
+#endif
+
 #ifdef SPLIT_KEYBOARD
     thisHand = isLeftHand ? 0 : NUMBER_OF_ENCODERS;
     thatHand = NUMBER_OF_ENCODERS - thisHand;
 #endif
 }
 
-static bool encoder_update(uint8_t index, uint8_t state) {
+/* Returns the quadrature steps taken since the last call, and the current position of the pads in state */
+static int16_t encoder_read_pulses(uint8_t i, uint8_t *state) {
+#ifdef ENCODER_TIMERS
+    if (encoder_timers[i]) {
+        // the timer counts up when pad A leads pad B, encoder_LUT counts that as negative
+        uint16_t count         = encoder_timers[i]->CNT;
+        int16_t  delta         = encoder_timer_count[i] - count;
+        encoder_timer_count[i] = count;
+        *state                 = (readPin(encoders_pad_a[i]) << 0) | (readPin(encoders_pad_b[i]) << 1);
+        return delta;
+    }
+#endif
+#ifdef ENCODER_INTERRUPT
+    // the pulses are counted as they happen, only collect them here
+    chSysLock();
+    int16_t delta         = encoder_isr_pulses[i];
+    encoder_isr_pulses[i] = 0;
+    *state                = encoder_state[i];
+    chSysUnlock();
+    return delta;
+#else
+    encoder_state[i] <<= 2;
+    encoder_state[i] |= (readPin(encoders_pad_a[i]) << 0) | (readPin(encoders_pad_b[i]) << 1);
+    *state = encoder_state[i];
+    return encoder_LUT[encoder_state[i] & 0xF];
+#endif
+}
+
+static bool encoder_update(uint8_t index, int16_t delta, uint8_t state) {
     bool    changed = false;
     uint8_t i       = index;
 
 #ifdef ENCODER_RESOLUTIONS
-    uint8_t resolution = encoder_resolutions[i];
+    int16_t resolution = encoder_resolutions[i];
 #else
-    uint8_t resolution = ENCODER_RESOLUTION;
+    int16_t resolution = ENCODER_RESOLUTION;
 #endif
 
 #ifdef SPLIT_KEYBOARD
     index += thisHand;
 #endif
-    encoder_pulses[i] += encoder_LUT[state & 0xF];
-    if (encoder_pulses[i] >= resolution) {
+    int16_t pulses = encoder_pulses[i] + delta;
+    while (pulses >= resolution) {
+        pulses -= resolution;
         encoder_value[index]++;
         changed = true;
         encoder_update_kb(index, ENCODER_COUNTER_CLOCKWISE);
     }
-    if (encoder_pulses[i] <= -resolution) { // direction is arbitrary here, but this clockwise
+    while (pulses <= -resolution) { // direction is arbitrary here, but this clockwise
+        pulses += resolution;
         encoder_value[index]--;
         changed = true;
         encoder_update_kb(index, ENCODER_CLOCKWISE);
     }
-    encoder_pulses[i] %= resolution;
+    encoder_pulses[i] = pulses;
 #ifdef ENCODER_DEFAULT_POS
     if ((state & 0x3) == ENCODER_DEFAULT_POS) {
         encoder_pulses[i] = 0;
     }
+#else
+    (void)state;
 #endif
     return changed;
 }
@@ -140,9 +266,9 @@ static bool encoder_update(uint8_t index, uint8_t state) {
 bool encoder_read(void) {
     bool changed = false;
     for (uint8_t i = 0; i < NUMBER_OF_ENCODERS; i++) {
-        encoder_state[i] <<= 2;
-        encoder_state[i] |= (readPin(encoders_pad_a[i]) << 0) | (readPin(encoders_pad_b[i]) << 1);
-        changed |= encoder_update(i, encoder_state[i]);
+        uint8_t state;
+        int16_t delta = encoder_read_pulses(i, &state);
+        changed |= encoder_update(i, delta, state);
     }
     return changed;
 }
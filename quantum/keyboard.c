@@ -108,6 +108,18 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #ifdef BLUETOOTH_ENABLE
 #    include "outputselect.h"
 #endif
+#ifdef PREDICTIVE_TAP_HOLD_ENABLE
+#    include "predictive_tap_hold.h"
+#endif
+#ifdef TASK_SCHEDULER_ENABLE
+#    include "task_scheduler.h"
+#endif
+#ifdef STAGED_INIT_ENABLE
+#    include "staged_init.h"
+#endif
+#ifdef MATRIX_IDLE_ENABLE
+#    include "matrix_idle.h"
+#endif
 
 static uint32_t last_input_modification_time = 0;
 uint32_t        last_input_activity_time(void) {
@@ -139,6 +151,17 @@ void last_encoder_activity_trigger(void) {
     last_encoder_modification_time = last_input_modification_time = timer_read32();
 }
 
+static uint32_t last_pointing_device_modification_time = 0;
+uint32_t        last_pointing_device_activity_time(void) {
+    return last_pointing_device_modification_time;
+}
+uint32_t last_pointing_device_activity_elapsed(void) {
+    return timer_elapsed32(last_pointing_device_modification_time);
+}
+void last_pointing_device_activity_trigger(void) {
+    last_pointing_device_modification_time = last_input_modification_time = timer_read32();
+}
+
 // Only enable this if console is enabled to print to
 #if defined(DEBUG_MATRIX_SCAN_RATE)
 static uint32_t matrix_timer           = 0;
@@ -333,27 +356,30 @@ void housekeeping_task(void) {
 void quantum_init(void) {
     magic();
     led_init_ports();
-#ifdef BACKLIGHT_ENABLE
-    backlight_init_ports();
-#endif
-#ifdef AUDIO_ENABLE
-    audio_init();
-#endif
-#ifdef LED_MATRIX_ENABLE
-    led_matrix_init();
-#endif
-#ifdef RGB_MATRIX_ENABLE
-    rgb_matrix_init();
-#endif
 #if defined(UNICODE_COMMON_ENABLE)
     unicode_input_mode_init();
 #endif
-#ifdef HAPTIC_ENABLE
-    haptic_init();
-#endif
 #if defined(BLUETOOTH_ENABLE) && defined(OUTPUT_AUTO_ENABLE)
     set_output(OUTPUT_AUTO);
 #endif
+#ifndef STAGED_INIT_ENABLE
+    // with STAGED_INIT_ENABLE these run from the main loop, see staged_init.c
+#    ifdef BACKLIGHT_ENABLE
+    backlight_init_ports();
+#    endif
+#    ifdef AUDIO_ENABLE
+    audio_init();
+#    endif
+#    ifdef LED_MATRIX_ENABLE
+    led_matrix_init();
+#    endif
+#    ifdef RGB_MATRIX_ENABLE
+    rgb_matrix_init();
+#    endif
+#    ifdef HAPTIC_ENABLE
+    haptic_init();
+#    endif
+#endif
 }
 
 /** \brief keyboard_init
@@ -363,6 +389,9 @@ void quantum_init(void) {
 void keyboard_init(void) {
     timer_init();
     sync_timer_init();
+#ifdef STAGED_INIT_ENABLE
+    staged_init_begin();
+#endif
 #ifdef VIA_ENABLE
     via_init();
 #endif
@@ -374,20 +403,22 @@ void keyboard_init(void) {
 #if defined(CRC_ENABLE)
     crc_init();
 #endif
-#ifdef OLED_ENABLE
+#ifndef STAGED_INIT_ENABLE
+#    ifdef OLED_ENABLE
     oled_init(OLED_ROTATION_0);
-#endif
-#ifdef ST7565_ENABLE
+#    endif
+#    ifdef ST7565_ENABLE
     st7565_init(DISPLAY_ROTATION_0);
-#endif
-#ifdef PS2_MOUSE_ENABLE
+#    endif
+#    ifdef PS2_MOUSE_ENABLE
     ps2_mouse_init();
-#endif
-#ifdef BACKLIGHT_ENABLE
+#    endif
+#    ifdef BACKLIGHT_ENABLE
     backlight_init();
-#endif
-#ifdef RGBLIGHT_ENABLE
+#    endif
+#    ifdef RGBLIGHT_ENABLE
     rgblight_init();
+#    endif
 #endif
 #ifdef ENCODER_ENABLE
     encoder_init();
@@ -395,7 +426,10 @@ void keyboard_init(void) {
 #ifdef STENO_ENABLE
     steno_init();
 #endif
-#ifdef POINTING_DEVICE_ENABLE
+#ifdef PREDICTIVE_TAP_HOLD_ENABLE
+    predictive_tap_hold_init();
+#endif
+#if defined(POINTING_DEVICE_ENABLE) && !defined(STAGED_INIT_ENABLE)
     pointing_device_init();
 #endif
 #if defined(NKRO_ENABLE) && defined(FORCE_NKRO)
@@ -419,7 +453,12 @@ void keyboard_init(void) {
     debug_enable = true;
 #endif
 
+#ifdef STAGED_INIT_ENABLE
+    // the remaining subsystems and keyboard_post_init_kb() follow from the main loop
+    staged_init_end();
+#else
     keyboard_post_init_kb(); /* Always keep this last */
+#endif
 }
 
 /** \brief key_event_task
@@ -448,7 +487,12 @@ bool matrix_scan_task(void) {
     uint8_t keys_processed = 0;
 #endif
 
+#ifdef MATRIX_IDLE_ENABLE
+    // while idle the matrix is only scanned once a key goes down
+    uint8_t matrix_changed = matrix_idle_scan_needed() ? matrix_scan() : 0;
+#else
     uint8_t matrix_changed = matrix_scan();
+#endif
     if (matrix_changed) last_matrix_activity_trigger();
 
     for (uint8_t r = 0; r < MATRIX_ROWS; r++) {
@@ -460,13 +504,23 @@ bool matrix_scan_task(void) {
                 continue;
             }
 #endif
+#ifdef DEFERRED_LOG_ENABLE
+            if (debug_matrix) dlog("matrix row %u: %08lX\n", r, (uint32_t)matrix_row);
+#else
             if (debug_matrix) matrix_print();
+#endif
             matrix_row_t col_mask = 1;
             for (uint8_t c = 0; c < MATRIX_COLS; c++, col_mask <<= 1) {
                 if (matrix_change & col_mask) {
                     if (should_process_keypress()) {
+#ifdef MATRIX_IDLE_ENABLE
+                        // the first press after idling is stamped with the wake up edge
+                        uint16_t event_time = matrix_idle_event_time();
+#else
+                        uint16_t event_time = timer_read();
+#endif
                         action_exec((keyevent_t){
-                            .key = (keypos_t){.row = r, .col = c}, .pressed = (matrix_row & col_mask), .time = (timer_read() | 1) /* time should not be 0 */
+                            .key = (keypos_t){.row = r, .col = c}, .pressed = (matrix_row & col_mask), .time = (event_time | 1) /* time should not be 0 */
                         });
                     }
                     // record a processed key
@@ -562,6 +616,14 @@ void quantum_task(void) {
 #ifdef AUTO_SHIFT_ENABLE
     autoshift_matrix_scan();
 #endif
+
+#ifdef PREDICTIVE_TAP_HOLD_ENABLE
+    predictive_tap_hold_task();
+#endif
+
+#ifdef TAP_CODE_DEFER_RELEASE
+    scheduled_unregister_task();
+#endif
 }
 
 /** \brief Keyboard task: Do keyboard routine jobs
@@ -579,17 +641,29 @@ void keyboard_task(void) {
     bool matrix_changed = matrix_scan_task();
     (void)matrix_changed;
 
+#ifdef STAGED_INIT_ENABLE
+    // one deferred init step per scan, the other tasks wait until all have run
+    if (!staged_init_task()) {
+        return;
+    }
+#endif
+
     quantum_task();
 
-#if defined(RGBLIGHT_ENABLE)
+#ifdef TASK_SCHEDULER_ENABLE
+    // render tasks share a time budget, see task_scheduler.c
+    task_scheduler_task();
+#else
+#    if defined(RGBLIGHT_ENABLE)
     rgblight_task();
-#endif
+#    endif
 
-#ifdef LED_MATRIX_ENABLE
+#    ifdef LED_MATRIX_ENABLE
     led_matrix_task();
-#endif
-#ifdef RGB_MATRIX_ENABLE
+#    endif
+#    ifdef RGB_MATRIX_ENABLE
     rgb_matrix_task();
+#    endif
 #endif
 
 #if defined(BACKLIGHT_ENABLE)
@@ -604,7 +678,9 @@ void keyboard_task(void) {
 #endif
 
 #ifdef OLED_ENABLE
+#    ifndef TASK_SCHEDULER_ENABLE
     oled_task();
+#    endif
 #    if OLED_TIMEOUT > 0
     // Wake up oled if user is using those fabulous keys or spinning those encoders!
 #        ifdef ENCODER_ENABLE
@@ -616,7 +692,9 @@ void keyboard_task(void) {
 #endif
 
 #ifdef ST7565_ENABLE
+#    ifndef TASK_SCHEDULER_ENABLE
     st7565_task();
+#    endif
 #    if ST7565_TIMEOUT > 0
     // Wake up display if user is using those fabulous keys or spinning those encoders!
 #        ifdef ENCODER_ENABLE
@@ -663,4 +741,16 @@ void keyboard_task(void) {
 #endif
 
     led_task();
+
+#ifdef DEFERRED_LOG_ENABLE
+    deferred_log_task();
+#endif
+
+    // write back settings changed during the last EECONFIG_FLUSH_DELAY
+    eeconfig_task();
+
+#ifdef MATRIX_IDLE_ENABLE
+    // sleeps once the matrix has been idle for MATRIX_IDLE_TIMEOUT
+    matrix_idle_task();
+#endif
 }
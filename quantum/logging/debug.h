@@ -167,3 +167,7 @@ extern debug_config_t debug_config;
 #    define debug_bin_reverse(data)
 
 #endif /* NO_DEBUG */
+
+#ifdef DEFERRED_LOG_ENABLE
+#    include "deferred_log.h"
+#endif
@@ -0,0 +1,150 @@
+/* Copyright 2022 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+#include "deferred_log.h"
+#include "sendchar.h"
+#include "timer.h"
+#include "atomic_util.h"
+
+/* Record layout:
+ *   marker   DEFERRED_LOG_MARKER
+ *   length   number of bytes that follow
+ *   body     COBS encoded, so that it never contains a zero byte
+ * The decoded body holds, all fields little endian:
+ *   time     timer_read() when the record was queued
+ *   id       address of the format string, sizeof(uintptr_t) bytes
+ *   args     one uint32_t per argument
+ * A record with a zero id carries the number of dropped records.
+ *
+ * Console readers like hid_listen stop at the first zero byte of a packet and
+ * the console pads partial packets with zeros, so records must not contain any.
+ */
+#define BODY_HEADER_SIZE (sizeof(uint16_t) + sizeof(uintptr_t))
+#define BODY_MAX_SIZE (BODY_HEADER_SIZE + DEFERRED_LOG_MAX_ARGS * sizeof(uint32_t))
+#define RECORD_MAX_SIZE (2 + 1 + BODY_MAX_SIZE)
+#define BUFFER_MASK (DEFERRED_LOG_BUFFER_SIZE - 1)
+
+_Static_assert(RECORD_MAX_SIZE <= DEFERRED_LOG_BUFFER_SIZE, "DEFERRED_LOG_BUFFER_SIZE is too small for a record");
+_Static_assert(BODY_MAX_SIZE < 254, "DEFERRED_LOG_MAX_ARGS is too large for a single COBS block");
+
+static uint8_t  buffer[DEFERRED_LOG_BUFFER_SIZE];
+static uint16_t head        = 0; // written by producers only
+static uint16_t tail        = 0; // written by deferred_log_task only
+static uint16_t dropped     = 0;
+static uint16_t flush_timer = 0;
+
+/* Replaces every zero byte with the distance to the next one, which takes a
+ * single extra byte for anything shorter than 254 bytes.
+ */
+static uint8_t cobs_encode(uint8_t *out, const uint8_t *in, uint8_t size) {
+    uint8_t code = 0;
+
+    out[code] = 1;
+    for (uint8_t i = 0; i < size; i++) {
+        if (in[i]) {
+            out[i + 1] = in[i];
+            out[code]++;
+        } else {
+            code      = i + 1;
+            out[code] = 1;
+        }
+    }
+    return size + 1;
+}
+
+/** \brief Queues a record
+ *
+ * Callable from interrupts. The record is assembled on the stack and copied
+ * into the ring with interrupts masked, so concurrent producers never
+ * interleave. When the ring is full the record is counted and discarded.
+ */
+void deferred_log_write(const char *fmt, uint8_t argc, const uint32_t *argv) {
+    uint8_t   body[BODY_MAX_SIZE];
+    uint8_t   record[RECORD_MAX_SIZE];
+    uint16_t  time = timer_read();
+    uintptr_t id   = (uintptr_t)fmt;
+
+    memcpy(&body[0], &time, sizeof(time));
+    memcpy(&body[sizeof(time)], &id, sizeof(id));
+    memcpy(&body[BODY_HEADER_SIZE], argv, argc * sizeof(uint32_t));
+
+    record[0]    = DEFERRED_LOG_MARKER;
+    record[1]    = cobs_encode(&record[2], body, BODY_HEADER_SIZE + argc * sizeof(uint32_t));
+    uint8_t size = 2 + record[1];
+
+    ATOMIC_BLOCK_RESTORESTATE {
+        if ((uint16_t)(DEFERRED_LOG_BUFFER_SIZE - (uint16_t)(head - tail)) < size) {
+            dropped++;
+        } else {
+            for (uint8_t i = 0; i < size; i++) {
+                buffer[(head + i) & BUFFER_MASK] = record[i];
+            }
+            head += size;
+        }
+    }
+}
+
+uint16_t deferred_log_dropped(void) {
+    return dropped;
+}
+
+/** \brief Drains the ring to the console
+ *
+ * Bytes are handed over in DEFERRED_LOG_PACKET_SIZE chunks; a partial packet
+ * is only sent once it has waited DEFERRED_LOG_FLUSH_INTERVAL. Never blocks,
+ * whatever the console does not accept stays queued for the next call.
+ */
+void deferred_log_task(void) {
+    uint16_t lost;
+    ATOMIC_BLOCK_RESTORESTATE {
+        lost    = dropped;
+        dropped = 0;
+    }
+    if (lost) {
+        uint32_t count = lost;
+        deferred_log_write(NULL, 1, &count);
+    }
+
+    uint16_t pending;
+    ATOMIC_BLOCK_RESTORESTATE {
+        pending = head - tail;
+    }
+    if (pending == 0) {
+        flush_timer = timer_read();
+        return;
+    }
+    if (pending < DEFERRED_LOG_PACKET_SIZE && timer_elapsed(flush_timer) < DEFERRED_LOG_FLUSH_INTERVAL) {
+        return;
+    }
+
+    while (pending) {
+        uint16_t offset = tail & BUFFER_MASK;
+        uint16_t chunk  = DEFERRED_LOG_BUFFER_SIZE - offset;
+        if (chunk > pending) chunk = pending;
+        if (chunk > DEFERRED_LOG_PACKET_SIZE) chunk = DEFERRED_LOG_PACKET_SIZE;
+
+        uint8_t sent = sendchar_buffer(&buffer[offset], chunk);
+        ATOMIC_BLOCK_RESTORESTATE {
+            tail += sent;
+        }
+        pending -= sent;
+        if (sent < chunk) {
+            break;
+        }
+    }
+    flush_timer = timer_read();
+}
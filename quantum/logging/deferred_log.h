@@ -0,0 +1,85 @@
+/* Copyright 2022 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include "progmem.h"
+#include "debug.h"
+
+/* ring buffer size in bytes, must be a power of two */
+#ifndef DEFERRED_LOG_BUFFER_SIZE
+#    define DEFERRED_LOG_BUFFER_SIZE 512
+#endif
+
+/* maximum number of arguments per record */
+#ifndef DEFERRED_LOG_MAX_ARGS
+#    define DEFERRED_LOG_MAX_ARGS 4
+#endif
+
+/* bytes handed to the console at once, matches the console endpoint */
+#ifndef DEFERRED_LOG_PACKET_SIZE
+#    define DEFERRED_LOG_PACKET_SIZE 32
+#endif
+
+/* time after which a partial packet is sent anyway (ms) */
+#ifndef DEFERRED_LOG_FLUSH_INTERVAL
+#    define DEFERRED_LOG_FLUSH_INTERVAL 20
+#endif
+
+/* first byte of every record, lets the host tell records from plain console text */
+#define DEFERRED_LOG_MARKER 0x1E
+
+#if (DEFERRED_LOG_BUFFER_SIZE & (DEFERRED_LOG_BUFFER_SIZE - 1)) != 0 || DEFERRED_LOG_BUFFER_SIZE > 32768
+#    error "DEFERRED_LOG_BUFFER_SIZE must be a power of two no larger than 32768"
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void deferred_log_write(const char *fmt, uint8_t argc, const uint32_t *argv);
+void deferred_log_task(void);
+
+/* records lost to a full buffer since the last drop record was queued */
+uint16_t deferred_log_dropped(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#define DEFERRED_LOG_ARGC(...) (sizeof((const uint32_t[]){0, ##__VA_ARGS__}) / sizeof(uint32_t) - 1)
+
+/* Queue a log record without formatting it.
+ *
+ * Only the address of the format string and the raw arguments are stored, the
+ * host side (util/deferred_log_decode.py) formats them using the firmware ELF.
+ * Arguments are passed as 32 bit integers: %s only works for pointers to
+ * constant strings, cast with (uintptr_t), and 64 bit or floating point
+ * conversions are not supported.
+ */
+#ifndef NO_DEBUG
+#    define dlog(fmt, ...)                                                                                                 \
+        do {                                                                                                               \
+            if (debug_enable) {                                                                                            \
+                static const char dlog_fmt[] PROGMEM = fmt;                                                                \
+                _Static_assert(DEFERRED_LOG_ARGC(__VA_ARGS__) <= DEFERRED_LOG_MAX_ARGS, "too many dlog arguments");        \
+                deferred_log_write(dlog_fmt, DEFERRED_LOG_ARGC(__VA_ARGS__), (const uint32_t[]){0, ##__VA_ARGS__} + 1); \
+            }                                                                                                              \
+        } while (0)
+#else
+#    define dlog(fmt, ...)
+#endif
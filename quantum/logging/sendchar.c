@@ -20,3 +20,13 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 __attribute__((weak)) int8_t sendchar(uint8_t c) {
     return 0;
 }
+
+/* default implementation on top of sendchar(), stops at the first failure.
+ * Protocols whose sendchar() waits for the host provide their own. */
+__attribute__((weak)) uint8_t sendchar_buffer(const uint8_t *data, uint8_t length) {
+    uint8_t i = 0;
+    while (i < length && sendchar(data[i]) == 0) {
+        i++;
+    }
+    return i;
+}
@@ -28,6 +28,9 @@ typedef int8_t (*sendchar_func_t)(uint8_t c);
 /* transmit a character.  return 0 on success, -1 on error. */
 int8_t sendchar(uint8_t c);
 
+/* transmit up to length bytes without blocking.  return the number of bytes accepted. */
+uint8_t sendchar_buffer(const uint8_t *data, uint8_t length);
+
 #ifdef __cplusplus
 }
 #endif
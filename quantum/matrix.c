@@ -21,6 +21,9 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "matrix.h"
 #include "debounce.h"
 #include "quantum.h"
+#ifdef MATRIX_IDLE_ENABLE
+#    include "matrix_idle.h"
+#endif
 #ifdef SPLIT_KEYBOARD
 #    include "split_common/split_util.h"
 #    include "split_common/transactions.h"
@@ -130,6 +133,42 @@ __attribute__((weak)) void matrix_read_cols_on_row(matrix_row_t current_matrix[]
     current_matrix[current_row] = current_row_value;
 }
 
+#    ifdef MATRIX_IDLE_ENABLE
+// every key has its own input, nothing needs parking
+bool matrix_idle_enter(void) {
+    for (uint8_t row = 0; row < ROWS_PER_HAND; row++) {
+        for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+            if (direct_pins[row][col] != NO_PIN && !matrix_idle_watch_pin(direct_pins[row][col])) {
+                matrix_idle_exit();
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+void matrix_idle_exit(void) {
+    for (uint8_t row = 0; row < ROWS_PER_HAND; row++) {
+        for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+            if (direct_pins[row][col] != NO_PIN) {
+                matrix_idle_unwatch_pin(direct_pins[row][col]);
+            }
+        }
+    }
+}
+
+bool matrix_idle_key_down(void) {
+    for (uint8_t row = 0; row < ROWS_PER_HAND; row++) {
+        for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+            if (readMatrixPin(direct_pins[row][col]) == 0) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+#    endif
+
 #elif defined(DIODE_DIRECTION)
 #    if defined(MATRIX_ROW_PINS) && defined(MATRIX_COL_PINS)
 #        if (DIODE_DIRECTION == COL2ROW)
@@ -195,6 +234,41 @@ __attribute__((weak)) void matrix_read_cols_on_row(matrix_row_t current_matrix[]
     current_matrix[current_row] = current_row_value;
 }
 
+#            ifdef MATRIX_IDLE_ENABLE
+// all rows selected at once, a key press on any row pulls its col low
+bool matrix_idle_enter(void) {
+    for (uint8_t x = 0; x < ROWS_PER_HAND; x++) {
+        select_row(x);
+    }
+    for (uint8_t x = 0; x < MATRIX_COLS; x++) {
+        if (col_pins[x] != NO_PIN && !matrix_idle_watch_pin(col_pins[x])) {
+            matrix_idle_exit();
+            return false;
+        }
+    }
+    return true;
+}
+
+void matrix_idle_exit(void) {
+    for (uint8_t x = 0; x < MATRIX_COLS; x++) {
+        if (col_pins[x] != NO_PIN) {
+            matrix_idle_unwatch_pin(col_pins[x]);
+        }
+    }
+    unselect_rows();
+    matrix_output_unselect_delay(0, true);
+}
+
+bool matrix_idle_key_down(void) {
+    for (uint8_t x = 0; x < MATRIX_COLS; x++) {
+        if (readMatrixPin(col_pins[x]) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+#            endif
+
 #        elif (DIODE_DIRECTION == ROW2COL)
 
 static bool select_col(uint8_t col) {
@@ -259,6 +333,41 @@ __attribute__((weak)) void matrix_read_rows_on_col(matrix_row_t current_matrix[]
     matrix_output_unselect_delay(current_col, key_pressed); // wait for all Row signals to go HIGH
 }
 
+#            ifdef MATRIX_IDLE_ENABLE
+// all cols selected at once, a key press on any col pulls its row low
+bool matrix_idle_enter(void) {
+    for (uint8_t x = 0; x < MATRIX_COLS; x++) {
+        select_col(x);
+    }
+    for (uint8_t x = 0; x < ROWS_PER_HAND; x++) {
+        if (row_pins[x] != NO_PIN && !matrix_idle_watch_pin(row_pins[x])) {
+            matrix_idle_exit();
+            return false;
+        }
+    }
+    return true;
+}
+
+void matrix_idle_exit(void) {
+    for (uint8_t x = 0; x < ROWS_PER_HAND; x++) {
+        if (row_pins[x] != NO_PIN) {
+            matrix_idle_unwatch_pin(row_pins[x]);
+        }
+    }
+    unselect_cols();
+    matrix_output_unselect_delay(0, true);
+}
+
+bool matrix_idle_key_down(void) {
+    for (uint8_t x = 0; x < ROWS_PER_HAND; x++) {
+        if (readMatrixPin(row_pins[x]) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+#            endif
+
 #        else
 #            error DIODE_DIRECTION must be one of COL2ROW or ROW2COL!
 #        endif
@@ -320,6 +429,11 @@ __attribute__((weak)) bool transport_master_if_connected(matrix_row_t master_mat
 uint8_t matrix_scan(void) {
     matrix_row_t curr_matrix[MATRIX_ROWS] = {0};
 
+#ifdef MATRIX_IDLE_ENABLE
+    // the suspend loop scans without going through keyboard_task
+    matrix_idle_wake();
+#endif
+
 #if defined(DIRECT_PINS) || (DIODE_DIRECTION == COL2ROW)
     // Set row, read cols
     for (uint8_t current_row = 0; current_row < ROWS_PER_HAND; current_row++) {
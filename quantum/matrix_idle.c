@@ -0,0 +1,231 @@
+/* Copyright 2022 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "matrix_idle.h"
+#include "matrix.h"
+#include "keyboard.h"
+#include "timer.h"
+
+#if defined(PROTOCOL_CHIBIOS)
+#    include <ch.h>
+#    include <hal.h>
+#    if !PAL_USE_CALLBACKS
+#        error "MATRIX_IDLE_ENABLE requires PAL_USE_CALLBACKS to be TRUE in halconf.h"
+#    endif
+#elif defined(__AVR__)
+#    include <avr/interrupt.h>
+#    include <avr/sleep.h>
+#endif
+
+#ifdef SPLIT_KEYBOARD
+#    error "MATRIX_IDLE_ENABLE is not supported on split keyboards"
+#endif
+
+// a wake up only stamps a key press reported within this time (ms), covers debouncing
+#define WAKE_STAMP_WINDOW 50
+
+static bool     idle        = false;
+static bool     unavailable = false;
+static bool     wake_stamp  = false;
+static uint16_t wake_time   = 0;
+
+#if defined(PROTOCOL_CHIBIOS)
+static BSEMAPHORE_DECL(wake_sem, true);
+static volatile bool      wake_edge  = false;
+static volatile systime_t wake_ticks = 0;
+
+static void matrix_idle_isr(void *arg) {
+    (void)arg;
+    chSysLockFromISR();
+    if (!wake_edge) {
+        wake_edge  = true;
+        wake_ticks = chVTGetSystemTimeX();
+    }
+    chBSemSignalI(&wake_sem);
+    chSysUnlockFromISR();
+}
+
+#    if defined(MCU_STM32)
+// EXTI lines are selected by pad number, A3 and B3 share one
+static uint16_t watched_pads = 0;
+static pin_t    watched_pins[16];
+#    endif
+
+bool matrix_idle_watch_pin(pin_t pin) {
+#    if defined(MCU_STM32)
+    uint8_t pad = PAL_PAD(pin);
+    if (watched_pads & (1 << pad)) {
+        return false;
+    }
+#        ifdef palIsLineEventEnabledX
+    // armed by another driver, e.g. an encoder or PS/2
+    if (palIsLineEventEnabledX(pin)) {
+        return false;
+    }
+#        endif
+    watched_pads |= 1 << pad;
+    watched_pins[pad] = pin;
+#    endif
+    palEnableLineEvent(pin, PAL_EVENT_MODE_FALLING_EDGE);
+    palSetLineCallback(pin, matrix_idle_isr, NULL);
+    return true;
+}
+
+void matrix_idle_unwatch_pin(pin_t pin) {
+#    if defined(MCU_STM32)
+    uint8_t pad = PAL_PAD(pin);
+    if (!(watched_pads & (1 << pad)) || watched_pins[pad] != pin) {
+        return;
+    }
+    watched_pads &= ~(1 << pad);
+#    endif
+    palDisableLineEvent(pin);
+}
+
+/* Blocks the main thread until an input edge or the wake interval, the idle
+ * thread sleeps the core in the meantime. With a tickless kernel nothing else
+ * wakes it up.
+ */
+static void matrix_idle_sleep(void) {
+    chBSemWaitTimeout(&wake_sem, TIME_MS2I(MATRIX_IDLE_WAKE_INTERVAL));
+}
+#else
+bool matrix_idle_watch_pin(pin_t pin) {
+    return true;
+}
+void matrix_idle_unwatch_pin(pin_t pin) {}
+
+/* Without a pin interrupt for every input, sleep until the next interrupt,
+ * the timer tick at the latest, and check the parked inputs again.
+ */
+static void matrix_idle_sleep(void) {
+#    if defined(__AVR__)
+    set_sleep_mode(SLEEP_MODE_IDLE);
+    sleep_enable();
+    sei();
+    sleep_cpu();
+    sleep_disable();
+#    endif
+}
+#endif
+
+__attribute__((weak)) bool matrix_idle_enter(void) {
+    return false;
+}
+__attribute__((weak)) void matrix_idle_exit(void) {}
+__attribute__((weak)) bool matrix_idle_key_down(void) {
+    return true;
+}
+
+bool matrix_idle_active(void) {
+    return idle;
+}
+
+/** \brief Leaves idle mode
+ *
+ * Restores the matrix pins for scanning and remembers when the wake up edge
+ * arrived, so the key press it belongs to is stamped with that time.
+ */
+void matrix_idle_wake(void) {
+    if (!idle) {
+        return;
+    }
+    idle = false;
+    matrix_idle_exit();
+
+    wake_time = timer_read();
+#if defined(PROTOCOL_CHIBIOS)
+    chSysLock();
+    if (wake_edge) {
+        wake_time -= TIME_I2MS(chVTTimeElapsedSinceX(wake_ticks));
+        wake_edge = false;
+    }
+    chSysUnlock();
+#endif
+    wake_stamp = true;
+}
+
+/** \brief Whether matrix_scan() needs to run
+ *
+ * While idle only the parked inputs are checked, which is a single read per
+ * port instead of a full scan.
+ */
+bool matrix_idle_scan_needed(void) {
+    if (!idle) {
+        return true;
+    }
+#if defined(PROTOCOL_CHIBIOS)
+    if (!wake_edge && !matrix_idle_key_down()) {
+#else
+    if (!matrix_idle_key_down()) {
+#endif
+        return false;
+    }
+    matrix_idle_wake();
+    return true;
+}
+
+/** \brief Timestamp for a key event
+ *
+ * The first press after a wake up gets the time of the wake up edge, any
+ * other event the current time.
+ */
+uint16_t matrix_idle_event_time(void) {
+    uint16_t now = timer_read();
+    if (wake_stamp) {
+        wake_stamp = false;
+        if (TIMER_DIFF_16(now, wake_time) <= WAKE_STAMP_WINDOW) {
+            return wake_time;
+        }
+    }
+    return now;
+}
+
+static bool matrix_idle_all_released(void) {
+    for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+        if (matrix_get_row(row)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/** \brief Enters idle mode and sleeps while in it
+ *
+ * Called at the end of keyboard_task. Once there has been no input from the
+ * matrix, encoders or pointing device for MATRIX_IDLE_TIMEOUT with no key
+ * held, the strobes are parked and every call sleeps until a key goes down or
+ * the wake interval expires. Encoder or pointing device activity seen during
+ * the wake intervals leaves idle mode again.
+ */
+void matrix_idle_task(void) {
+    if (last_input_activity_elapsed() < MATRIX_IDLE_TIMEOUT) {
+        matrix_idle_wake();
+        return;
+    }
+    if (!idle) {
+        if (unavailable || !matrix_idle_all_released()) {
+            return;
+        }
+        if (!matrix_idle_enter()) {
+            unavailable = true;
+            return;
+        }
+        idle       = true;
+        wake_stamp = false;
+    }
+    matrix_idle_sleep();
+}
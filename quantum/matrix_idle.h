@@ -0,0 +1,64 @@
+/* Copyright 2022 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "gpio.h"
+
+/* time without input activity before scanning stops (ms) */
+#ifndef MATRIX_IDLE_TIMEOUT
+#    define MATRIX_IDLE_TIMEOUT 1000
+#endif
+
+/* longest sleep while idle, the rest of keyboard_task runs at this interval (ms) */
+#ifndef MATRIX_IDLE_WAKE_INTERVAL
+#    define MATRIX_IDLE_WAKE_INTERVAL 10
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Provided by the matrix, the defaults leave idle mode unused.
+ *
+ * matrix_idle_enter() parks the strobes so that pressing any key pulls an
+ * input low, and arms the inputs with matrix_idle_watch_pin(). It returns
+ * false if the matrix cannot be parked or an input cannot be watched, idle
+ * mode is then not tried again. matrix_idle_key_down() reads the parked
+ * inputs, matrix_idle_exit() restores the pins for scanning.
+ *
+ * matrix_idle_watch_pin() fails for an input whose interrupt is taken, on
+ * STM32 by any pin with the same pad number. matrix_idle_unwatch_pin() only
+ * disarms inputs it armed itself.
+ */
+bool matrix_idle_enter(void);
+void matrix_idle_exit(void);
+bool matrix_idle_key_down(void);
+
+bool matrix_idle_watch_pin(pin_t pin);
+void matrix_idle_unwatch_pin(pin_t pin);
+
+bool     matrix_idle_active(void);
+bool     matrix_idle_scan_needed(void);
+void     matrix_idle_wake(void);
+uint16_t matrix_idle_event_time(void);
+void     matrix_idle_task(void);
+
+#ifdef __cplusplus
+}
+#endif
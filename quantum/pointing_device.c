@@ -19,6 +19,7 @@
 #include "pointing_device.h"
 #include <string.h>
 #include "timer.h"
+#include "keyboard.h"
 #ifdef MOUSEKEY_ENABLE
 #    include "mousekey.h"
 #endif
@@ -27,7 +28,6 @@
 #endif
 #if defined(SPLIT_POINTING_ENABLE)
 #    include "transactions.h"
-#    include "keyboard.h"
 
 report_mouse_t shared_mouse_report = {};
 uint16_t       shared_cpi          = 0;
@@ -167,6 +167,7 @@ __attribute__((weak)) void pointing_device_send(void) {
     // If you need to do other things, like debugging, this is the place to do it.
     if (has_mouse_report_changed(local_mouse_report, old_report)) {
         host_mouse_send(&local_mouse_report);
+        last_pointing_device_activity_trigger();
     }
     // send it and 0 it out except for buttons, so those stay until they are explicity over-ridden using update_pointing_device
     local_mouse_report.x = 0;
@@ -208,7 +208,8 @@ const pointing_device_driver_t pointing_device_driver = {
 // clang-format on
 #elif defined(POINTING_DEVICE_DRIVER_pmw3360)
 static void pmw3360_device_init(void) {
-    pmw3360_init();
+    // the firmware upload continues from pmw3360_read_burst()
+    pmw3360_init_start();
 }
 
 report_mouse_t pmw3360_get_report(report_mouse_t mouse_report) {
@@ -246,7 +247,8 @@ const pointing_device_driver_t pointing_device_driver = {
 // clang-format on
 #elif defined(POINTING_DEVICE_DRIVER_pmw3389)
 static void pmw3389_device_init(void) {
-    pmw3389_init();
+    // the firmware upload continues from pmw3389_read_burst()
+    pmw3389_init_start();
 }
 
 report_mouse_t pmw3389_get_report(report_mouse_t mouse_report) {
@@ -0,0 +1,407 @@
+/* Copyright 2022 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+#include "predictive_tap_hold.h"
+#include "action_tapping.h"
+#include "eeprom.h"
+#include "timer.h"
+#include "print.h"
+#include "debug.h"
+
+/* Statistics are keyed by the delay between pressing a tap-hold key and the
+ * next key going down while it is still held ("overlap onset"). Every such
+ * overlap is labelled with the decision the tap-hold logic makes for the key
+ * once it settles, so the configured behaviour (IGNORE_MOD_TAP_INTERRUPT,
+ * PERMISSIVE_HOLD, ...) is what gets learned.
+ * When the bin for the current onset holds enough samples and is dominated by
+ * taps, the tap is settled at the overlapping press instead of at release.
+ * A prediction counts as a miss when the other key is released first or the
+ * tapping term runs out with the tap-hold key still down.
+ */
+
+#ifdef PREDICTIVE_TAP_HOLD_EEPROM_ADDR
+// the low byte changes with the layout, so stale statistics are not loaded
+#    define PREDICTIVE_TAP_HOLD_EEPROM_MAGIC (0xA100 | ((PREDICTIVE_TAP_HOLD_KEYS - 1) << 4) | (PREDICTIVE_TAP_HOLD_BINS - 1))
+#    define PREDICTIVE_TAP_HOLD_EEPROM_SLOT(i) ((uint8_t *)(PREDICTIVE_TAP_HOLD_EEPROM_ADDR) + 2 + (i) * sizeof(predictive_tap_hold_stats_t))
+#endif
+
+#define EMPTY_KEY ((keypos_t){.row = 255, .col = 255})
+
+// predicted keys whose physical release still has to be swallowed
+#define OWED_RELEASES 4
+
+enum { OBSERVE_IDLE, OBSERVE_HELD, OBSERVE_OVERLAP };
+
+typedef struct {
+    keypos_t key;
+    uint16_t time;
+    uint16_t term;
+} observed_key_t;
+
+/* The tap-hold key being observed. If the key that overlapped it is a tap-hold
+ * key as well, it is remembered in next, together with the first press
+ * overlapping it, so observation can carry on with it once key is settled.
+ */
+static struct {
+    observed_key_t key;
+    observed_key_t next;
+    keypos_t       other;
+    keypos_t       next_other;
+    uint16_t       next_other_time;
+    uint8_t        bin;
+    uint8_t        state;
+    bool           has_next;
+    bool           next_overlap;
+} observation;
+
+/* The last predicted tap, checked for a miss until the key is released. */
+static struct {
+    observed_key_t key;
+    keypos_t       other;
+    uint8_t        bin;
+    bool           active;
+} prediction;
+
+static predictive_tap_hold_stats_t stats[PREDICTIVE_TAP_HOLD_KEYS];
+static uint16_t                    stats_dirty   = 0;
+static uint32_t                    flush_timer   = 0;
+static bool                        enabled       = true;
+static keypos_t                    release_owed[OWED_RELEASES];
+static uint16_t                    predict_count = 0;
+
+static predictive_tap_hold_stats_t *find_stats(keypos_t key) {
+    for (uint8_t i = 0; i < PREDICTIVE_TAP_HOLD_KEYS; i++) {
+        if (KEYEQ(stats[i].key, key)) {
+            return &stats[i];
+        }
+    }
+    return NULL;
+}
+
+static uint16_t stats_samples(const predictive_tap_hold_stats_t *s) {
+    uint16_t total = 0;
+    for (uint8_t i = 0; i < PREDICTIVE_TAP_HOLD_BINS; i++) {
+        total += s->tap[i] + s->hold[i];
+    }
+    return total;
+}
+
+static predictive_tap_hold_stats_t *alloc_stats(keypos_t key) {
+    predictive_tap_hold_stats_t *slot = find_stats(key);
+    if (slot) {
+        return slot;
+    }
+
+    // take a free slot, or evict the least trained one
+    slot = find_stats(EMPTY_KEY);
+    if (!slot) {
+        slot = &stats[0];
+        for (uint8_t i = 1; i < PREDICTIVE_TAP_HOLD_KEYS; i++) {
+            if (stats_samples(&stats[i]) < stats_samples(slot)) {
+                slot = &stats[i];
+            }
+        }
+    }
+    memset(slot, 0, sizeof(*slot));
+    slot->key = key;
+    return slot;
+}
+
+/* Halve every counter so old habits fade and the counters never saturate. */
+static void age_stats(predictive_tap_hold_stats_t *s) {
+    for (uint8_t i = 0; i < PREDICTIVE_TAP_HOLD_BINS; i++) {
+        s->tap[i] >>= 1;
+        s->hold[i] >>= 1;
+    }
+    s->misses >>= 1;
+}
+
+static predictive_tap_hold_stats_t *record_outcome(keypos_t key, uint8_t bin, bool tap) {
+    predictive_tap_hold_stats_t *s    = alloc_stats(key);
+    uint8_t *                    bins = tap ? s->tap : s->hold;
+
+    if (bins[bin] == UINT8_MAX) {
+        age_stats(s);
+    }
+    bins[bin]++;
+
+    stats_dirty |= (1 << (s - stats));
+    return s;
+}
+
+/* A predicted tap turned out to be a hold, learn it as such. */
+static void record_miss(void) {
+    predictive_tap_hold_stats_t *s = record_outcome(prediction.key.key, prediction.bin, false);
+    if (s->misses < UINT8_MAX) {
+        s->misses++;
+    }
+    prediction.active = false;
+    dprintf("PTH: mispredicted %u,%u bin %u (misses %u)\n", prediction.key.key.row, prediction.key.key.col, prediction.bin, s->misses);
+}
+
+static bool observe_overlap(keypos_t other, uint16_t time) {
+    uint16_t elapsed = TIMER_DIFF_16(time, observation.key.time);
+    if (elapsed >= observation.key.term) {
+        return false;
+    }
+    observation.other = other;
+    observation.bin   = (uint32_t)elapsed * PREDICTIVE_TAP_HOLD_BINS / observation.key.term;
+    observation.state = OBSERVE_OVERLAP;
+    return true;
+}
+
+/* The observed key is settled, continue with the tap-hold key that overlapped it. */
+static void observe_next(void) {
+    observation.state = OBSERVE_IDLE;
+    if (!observation.has_next) {
+        return;
+    }
+    observation.key      = observation.next;
+    observation.has_next = false;
+    observation.state    = OBSERVE_HELD;
+    if (observation.next_overlap && !observe_overlap(observation.next_other, observation.next_other_time)) {
+        observation.state = OBSERVE_IDLE;
+    }
+}
+
+void predictive_tap_hold_reset(void) {
+    for (uint8_t i = 0; i < PREDICTIVE_TAP_HOLD_KEYS; i++) {
+        memset(&stats[i], 0, sizeof(stats[i]));
+        stats[i].key = EMPTY_KEY;
+    }
+    stats_dirty = (1 << PREDICTIVE_TAP_HOLD_KEYS) - 1;
+    for (uint8_t i = 0; i < OWED_RELEASES; i++) {
+        release_owed[i] = EMPTY_KEY;
+    }
+    observation.state = OBSERVE_IDLE;
+    prediction.active = false;
+    predict_count     = 0;
+}
+
+void predictive_tap_hold_init(void) {
+#ifdef PREDICTIVE_TAP_HOLD_EEPROM_ADDR
+    predictive_tap_hold_reset();
+    if (eeprom_read_word((uint16_t *)(PREDICTIVE_TAP_HOLD_EEPROM_ADDR)) == PREDICTIVE_TAP_HOLD_EEPROM_MAGIC) {
+        eeprom_read_block(stats, PREDICTIVE_TAP_HOLD_EEPROM_SLOT(0), sizeof(stats));
+        stats_dirty = 0;
+    }
+#else
+    predictive_tap_hold_reset();
+#endif
+    flush_timer = timer_read32();
+}
+
+/** \brief Persists the slots that changed since the last flush
+ *
+ * Writes are rate limited to PREDICTIVE_TAP_HOLD_FLUSH_INTERVAL, and only dirty slots are touched.
+ */
+void predictive_tap_hold_task(void) {
+#ifdef PREDICTIVE_TAP_HOLD_EEPROM_ADDR
+    if (!stats_dirty || timer_elapsed32(flush_timer) < PREDICTIVE_TAP_HOLD_FLUSH_INTERVAL) {
+        return;
+    }
+    eeprom_update_word((uint16_t *)(PREDICTIVE_TAP_HOLD_EEPROM_ADDR), PREDICTIVE_TAP_HOLD_EEPROM_MAGIC);
+    for (uint8_t i = 0; i < PREDICTIVE_TAP_HOLD_KEYS; i++) {
+        if (stats_dirty & (1 << i)) {
+            eeprom_update_block(&stats[i], PREDICTIVE_TAP_HOLD_EEPROM_SLOT(i), sizeof(stats[i]));
+        }
+    }
+#endif
+    stats_dirty = 0;
+    flush_timer = timer_read32();
+}
+
+void predictive_tap_hold_enable(void) {
+    enabled = true;
+}
+
+void predictive_tap_hold_disable(void) {
+    enabled = false;
+}
+
+void predictive_tap_hold_toggle(void) {
+    enabled = !enabled;
+}
+
+bool predictive_tap_hold_is_enabled(void) {
+    return enabled;
+}
+
+const predictive_tap_hold_stats_t *predictive_tap_hold_get_stats(keypos_t key) {
+    return find_stats(key);
+}
+
+/** \brief Tracks raw key events to find tap-hold overlaps
+ *
+ * Called for every event before the tapping state machine sees it.
+ */
+void predictive_tap_hold_observe(keyrecord_t *record) {
+    keyevent_t event = record->event;
+
+    if (prediction.active && event.time && TIMER_DIFF_16(event.time, prediction.key.time) >= prediction.key.term) {
+        // still held at the end of the tapping term
+        record_miss();
+    }
+    if (observation.state != OBSERVE_IDLE && event.time) {
+        uint16_t elapsed = TIMER_DIFF_16(event.time, observation.key.time);
+        if (observation.state == OBSERVE_HELD && elapsed >= observation.key.term) {
+            observation.state = OBSERVE_IDLE;
+        } else if (observation.state == OBSERVE_OVERLAP && elapsed >= 2 * observation.key.term) {
+            // the decision never reached process_record, e.g. a user function took over
+            observation.state = OBSERVE_IDLE;
+        }
+    }
+
+    if (IS_NOEVENT(event)) {
+        return;
+    }
+
+    if (prediction.active && !event.pressed) {
+        if (KEYEQ(event.key, prediction.key.key)) {
+            prediction.active = false;
+        } else if (KEYEQ(event.key, prediction.other)) {
+            record_miss();
+        }
+    }
+
+    switch (observation.state) {
+        case OBSERVE_IDLE:
+            if (event.pressed && is_tap_record(record)) {
+                observation.key.key  = event.key;
+                observation.key.time = event.time;
+                observation.key.term = get_tapping_term(get_record_keycode(record, false), record);
+                observation.state    = observation.key.term ? OBSERVE_HELD : OBSERVE_IDLE;
+            }
+            break;
+        case OBSERVE_HELD:
+            if (KEYEQ(event.key, observation.key.key)) {
+                // released without overlap, nothing to learn
+                observation.state = OBSERVE_IDLE;
+            } else if (event.pressed && observe_overlap(event.key, event.time)) {
+                observation.next.key     = event.key;
+                observation.next.time    = event.time;
+                observation.next.term    = is_tap_record(record) ? get_tapping_term(get_record_keycode(record, false), record) : 0;
+                observation.has_next     = observation.next.term != 0;
+                observation.next_overlap = false;
+            }
+            break;
+        case OBSERVE_OVERLAP:
+            // labelled by predictive_tap_hold_settled()
+            if (!observation.has_next) {
+                break;
+            }
+            if (KEYEQ(event.key, observation.next.key)) {
+                observation.has_next = false;
+            } else if (event.pressed && !observation.next_overlap) {
+                observation.next_other      = event.key;
+                observation.next_other_time = event.time;
+                observation.next_overlap    = true;
+            }
+            break;
+    }
+}
+
+/** \brief Labels an overlap with the decision made for the tap-hold key
+ *
+ * Called from process_record() once the action for the press has run, the tap
+ * count is zero at that point if the key was resolved as a hold, even when the
+ * action cancelled a tap itself.
+ */
+void predictive_tap_hold_settled(keyrecord_t *record) {
+    if (observation.state == OBSERVE_OVERLAP && record->event.pressed && KEYEQ(record->event.key, observation.key.key)) {
+        record_outcome(observation.key.key, observation.bin, record->tap.count > 0);
+        observe_next();
+    }
+}
+
+/** \brief Decides whether the tap can be settled at the first overlapping press
+ *
+ * Returns false, and so leaves the regular tap-hold logic in charge, unless the
+ * key is enabled, trained and has not been mispredicting.
+ */
+bool predictive_tap_hold_decide(keyrecord_t *tapping_key, keyevent_t event) {
+    if (!enabled || observation.state != OBSERVE_OVERLAP) {
+        return false;
+    }
+    if (!KEYEQ(observation.key.key, tapping_key->event.key) || !KEYEQ(observation.other, event.key)) {
+        return false;
+    }
+
+    const predictive_tap_hold_stats_t *s = find_stats(observation.key.key);
+    if (!s || s->misses >= PREDICTIVE_TAP_HOLD_MAX_MISSES) {
+        return false;
+    }
+
+    uint16_t taps  = s->tap[observation.bin];
+    uint16_t holds = s->hold[observation.bin];
+    if (taps + holds < PREDICTIVE_TAP_HOLD_MIN_SAMPLES || holds * PREDICTIVE_TAP_HOLD_CONFIDENCE >= taps) {
+        return false;
+    }
+
+    keypos_t *owed = NULL;
+    for (uint8_t i = 0; i < OWED_RELEASES; i++) {
+        if (KEYEQ(release_owed[i], EMPTY_KEY) || KEYEQ(release_owed[i], observation.key.key)) {
+            owed = &release_owed[i];
+            break;
+        }
+    }
+    if (!owed) {
+        return false;
+    }
+
+    dprintf("PTH: predicted tap %u,%u bin %u (%u/%u)\n", observation.key.key.row, observation.key.key.col, observation.bin, taps, holds);
+    *owed             = observation.key.key;
+    prediction.key    = observation.key;
+    prediction.other  = observation.other;
+    prediction.bin    = observation.bin;
+    prediction.active = true;
+    predict_count++;
+    observe_next();
+    return true;
+}
+
+/** \brief Swallows the physical release of a key whose tap was already sent */
+bool predictive_tap_hold_consume_release(keyevent_t event) {
+    if (!IS_RELEASED(event)) {
+        return false;
+    }
+    for (uint8_t i = 0; i < OWED_RELEASES; i++) {
+        if (KEYEQ(event.key, release_owed[i])) {
+            release_owed[i] = EMPTY_KEY;
+            return true;
+        }
+    }
+    return false;
+}
+
+void predictive_tap_hold_print(void) {
+    xprintf("predictive tap-hold: %s, %u predictions\n", enabled ? "on" : "off", predict_count);
+    for (uint8_t i = 0; i < PREDICTIVE_TAP_HOLD_KEYS; i++) {
+        if (KEYEQ(stats[i].key, EMPTY_KEY)) {
+            continue;
+        }
+        xprintf("%2u,%2u misses:%3u tap:", stats[i].key.row, stats[i].key.col, stats[i].misses);
+        for (uint8_t b = 0; b < PREDICTIVE_TAP_HOLD_BINS; b++) {
+            xprintf(" %3u", stats[i].tap[b]);
+        }
+        xprintf(" hold:");
+        for (uint8_t b = 0; b < PREDICTIVE_TAP_HOLD_BINS; b++) {
+            xprintf(" %3u", stats[i].hold[b]);
+        }
+        xprintf("\n");
+    }
+}
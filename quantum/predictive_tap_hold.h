@@ -0,0 +1,83 @@
+/* Copyright 2022 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "action.h"
+
+/* number of tap-hold keys tracked at once */
+#ifndef PREDICTIVE_TAP_HOLD_KEYS
+#    define PREDICTIVE_TAP_HOLD_KEYS 8
+#endif
+
+/* histogram resolution, the tapping term is split into this many bins */
+#ifndef PREDICTIVE_TAP_HOLD_BINS
+#    define PREDICTIVE_TAP_HOLD_BINS 8
+#endif
+
+/* samples needed in a bin before it is allowed to predict */
+#ifndef PREDICTIVE_TAP_HOLD_MIN_SAMPLES
+#    define PREDICTIVE_TAP_HOLD_MIN_SAMPLES 16
+#endif
+
+/* taps required per observed hold in a bin before it is allowed to predict */
+#ifndef PREDICTIVE_TAP_HOLD_CONFIDENCE
+#    define PREDICTIVE_TAP_HOLD_CONFIDENCE 16
+#endif
+
+/* mispredictions after which a key falls back to the regular tap-hold logic */
+#ifndef PREDICTIVE_TAP_HOLD_MAX_MISSES
+#    define PREDICTIVE_TAP_HOLD_MAX_MISSES 4
+#endif
+
+/* minimum time between two EEPROM writes of the statistics (ms) */
+#ifndef PREDICTIVE_TAP_HOLD_FLUSH_INTERVAL
+#    define PREDICTIVE_TAP_HOLD_FLUSH_INTERVAL 60000
+#endif
+
+#if PREDICTIVE_TAP_HOLD_KEYS > 16
+#    error "PREDICTIVE_TAP_HOLD_KEYS must not exceed 16"
+#endif
+#if PREDICTIVE_TAP_HOLD_BINS > 16
+#    error "PREDICTIVE_TAP_HOLD_BINS must not exceed 16"
+#endif
+
+typedef struct {
+    keypos_t key;
+    uint8_t  tap[PREDICTIVE_TAP_HOLD_BINS];
+    uint8_t  hold[PREDICTIVE_TAP_HOLD_BINS];
+    uint8_t  misses;
+} predictive_tap_hold_stats_t;
+
+void predictive_tap_hold_init(void);
+void predictive_tap_hold_task(void);
+
+void predictive_tap_hold_enable(void);
+void predictive_tap_hold_disable(void);
+void predictive_tap_hold_toggle(void);
+bool predictive_tap_hold_is_enabled(void);
+
+void                               predictive_tap_hold_reset(void);
+void                               predictive_tap_hold_print(void);
+const predictive_tap_hold_stats_t *predictive_tap_hold_get_stats(keypos_t key);
+
+/* Hooks used by action_tapping.c */
+void predictive_tap_hold_observe(keyrecord_t *record);
+void predictive_tap_hold_settled(keyrecord_t *record);
+bool predictive_tap_hold_decide(keyrecord_t *tapping_key, keyevent_t event);
+bool predictive_tap_hold_consume_release(keyevent_t event);
@@ -76,6 +76,10 @@ void do_code16(uint16_t code, void (*f)(uint8_t)) {
 }
 
 __attribute__((weak)) void register_code16(uint16_t code) {
+#ifdef TAP_CODE_DEFER_RELEASE
+    // before the weak mods below reach the host
+    scheduled_unregister_settle();
+#endif
     if (IS_MOD(code) || code == KC_NO) {
         do_code16(code, register_mods);
     } else {
@@ -93,16 +97,145 @@ __attribute__((weak)) void unregister_code16(uint16_t code) {
     }
 }
 
+void unregister_code16_delay(uint16_t code, uint16_t delay) {
+#ifdef TAP_CODE_DEFER_RELEASE
+    schedule_unregister_code16(code, delay);
+#else
+    if (delay > 0) {
+        wait_ms(delay);
+    }
+    unregister_code16(code);
+#endif
+}
+
 __attribute__((weak)) void tap_code16(uint16_t code) {
+#ifdef TAP_CODE_DEFER_RELEASE
+    schedule_tap_code16(code, code == KC_CAPS_LOCK ? TAP_HOLD_CAPS_DELAY : TAP_CODE_DELAY);
+#else
     register_code16(code);
-    if (code == KC_CAPS_LOCK) {
-        wait_ms(TAP_HOLD_CAPS_DELAY);
-    } else if (TAP_CODE_DELAY > 0) {
-        wait_ms(TAP_CODE_DELAY);
+    unregister_code16_delay(code, code == KC_CAPS_LOCK ? TAP_HOLD_CAPS_DELAY : TAP_CODE_DELAY);
+#endif
+}
+
+#ifdef TAP_CODE_DEFER_RELEASE
+/* Releases of tapped keycodes are queued instead of blocking for the tap delay.
+ * A tap issued while earlier taps are still queued queues its press as well,
+ * so the host always sees each key as its own press/release pair, in order,
+ * and the report never holds more than one queued key.
+ *
+ * Nothing here waits, except for room in a full queue and when a keycode is
+ * registered outside the queue. Then everything still queued is sent first,
+ * waiting out the hold time each tap has left, so the new key neither overlaps
+ * nor cuts short a tap the host needs held (KC_CAPS_LOCK on macOS).
+ */
+typedef struct {
+    uint16_t code;
+    uint16_t time; // release: when it is due, press: delay of the release that follows
+    bool     press;
+} scheduled_unregister_t;
+
+_Static_assert(TAP_CODE_DEFER_RELEASE_QUEUE_SIZE >= 2, "TAP_CODE_DEFER_RELEASE_QUEUE_SIZE must hold at least one tap");
+
+static scheduled_unregister_t scheduled_unregisters[TAP_CODE_DEFER_RELEASE_QUEUE_SIZE];
+static uint8_t                scheduled_unregister_head    = 0;
+static uint8_t                scheduled_unregister_count   = 0;
+static bool                   scheduled_unregister_running = false;
+
+static scheduled_unregister_t *scheduled_unregister_at(uint8_t index) {
+    return &scheduled_unregisters[(scheduled_unregister_head + index) % TAP_CODE_DEFER_RELEASE_QUEUE_SIZE];
+}
+
+static void scheduled_unregister_push(uint16_t code, uint16_t time, bool press) {
+    scheduled_unregister_t *entry = scheduled_unregister_at(scheduled_unregister_count++);
+
+    entry->code  = code;
+    entry->time  = time;
+    entry->press = press;
+}
+
+static void scheduled_unregister_pop(void) {
+    scheduled_unregister_t entry = *scheduled_unregister_at(0);
+
+    scheduled_unregister_head = (scheduled_unregister_head + 1) % TAP_CODE_DEFER_RELEASE_QUEUE_SIZE;
+    scheduled_unregister_count--;
+    if (entry.press) {
+        scheduled_unregister_running = true;
+        register_code16(entry.code);
+        scheduled_unregister_running = false;
+        // a queued press is always followed by its release
+        scheduled_unregister_at(0)->time = timer_read() + entry.time;
+    } else {
+        unregister_code16(entry.code);
+    }
+}
+
+static void scheduled_unregister_reserve(uint8_t slots) {
+    while (scheduled_unregister_count > TAP_CODE_DEFER_RELEASE_QUEUE_SIZE - slots) {
+        wait_ms(1);
+        scheduled_unregister_task();
+    }
+}
+
+void schedule_unregister_code16(uint16_t code, uint16_t delay) {
+    if (delay == 0 && scheduled_unregister_count == 0) {
+        unregister_code16(code);
+        return;
+    }
+    scheduled_unregister_reserve(1);
+    scheduled_unregister_push(code, timer_read() + delay, false);
+}
+
+void schedule_tap_code16(uint16_t code, uint16_t delay) {
+    if (scheduled_unregister_count == 0) {
+        register_code16(code);
+        schedule_unregister_code16(code, delay);
+        return;
+    }
+    scheduled_unregister_reserve(2);
+    scheduled_unregister_push(code, delay, true);
+    scheduled_unregister_push(code, 0, false);
+}
+
+void scheduled_unregister_settle(void) {
+    if (scheduled_unregister_running) {
+        return;
+    }
+    while (scheduled_unregister_count) {
+        scheduled_unregister_task();
+        if (scheduled_unregister_count) {
+            wait_ms(1);
+        }
+    }
+}
+
+void scheduled_unregister_flush(void) {
+    while (scheduled_unregister_count) {
+        scheduled_unregister_t entry = *scheduled_unregister_at(0);
+
+        scheduled_unregister_head = (scheduled_unregister_head + 1) % TAP_CODE_DEFER_RELEASE_QUEUE_SIZE;
+        scheduled_unregister_count--;
+        if (entry.press) {
+            // never sent, drop its release too
+            scheduled_unregister_head = (scheduled_unregister_head + 1) % TAP_CODE_DEFER_RELEASE_QUEUE_SIZE;
+            scheduled_unregister_count--;
+        } else {
+            unregister_code16(entry.code);
+        }
     }
-    unregister_code16(code);
 }
 
+void scheduled_unregister_task(void) {
+    while (scheduled_unregister_count) {
+        scheduled_unregister_t *entry = scheduled_unregister_at(0);
+
+        if (!entry->press && !timer_expired(timer_read(), entry->time)) {
+            break;
+        }
+        scheduled_unregister_pop();
+    }
+}
+#endif
+
 __attribute__((weak)) bool process_action_kb(keyrecord_t *record) {
     return true;
 }
@@ -143,6 +276,7 @@ void reset_keyboard(void) {
 #ifdef HAPTIC_ENABLE
     haptic_shutdown();
 #endif
+    eeconfig_flush();
     bootloader_jump();
 }
 
@@ -399,7 +533,12 @@ __attribute__((weak)) void startup_user() {}
 __attribute__((weak)) void shutdown_user() {}
 
 void suspend_power_down_quantum(void) {
+#ifdef TAP_CODE_DEFER_RELEASE
+    scheduled_unregister_flush();
+#endif
     suspend_power_down_kb();
+    // the host may cut power while suspended
+    eeconfig_flush();
 #ifndef NO_SUSPEND_POWER_DOWN
 // Turn off backlight
 #    ifdef BACKLIGHT_ENABLE
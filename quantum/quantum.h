@@ -247,6 +247,7 @@ void shutdown_user(void);
 
 void register_code16(uint16_t code);
 void unregister_code16(uint16_t code);
+void unregister_code16_delay(uint16_t code, uint16_t delay);
 void tap_code16(uint16_t code);
 
 const char *get_numeric_str(char *buf, size_t buf_len, uint32_t curr_num, char curr_pad);
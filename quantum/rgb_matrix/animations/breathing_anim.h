@@ -1,5 +1,5 @@
 #ifdef ENABLE_RGB_MATRIX_BREATHING
-RGB_MATRIX_EFFECT(BREATHING)
+RGB_MATRIX_EFFECT(BREATHING, SPEED)
 #    ifdef RGB_MATRIX_CUSTOM_EFFECT_IMPLS
 
 bool BREATHING(effect_params_t* params) {
@@ -1,5 +1,5 @@
 #ifdef ENABLE_RGB_MATRIX_HUE_BREATHING
-RGB_MATRIX_EFFECT(HUE_BREATHING)
+RGB_MATRIX_EFFECT(HUE_BREATHING, SPEED)
 #    ifdef RGB_MATRIX_CUSTOM_EFFECT_IMPLS
 
 // Change huedelta to adjust range of hue change. 0-255.
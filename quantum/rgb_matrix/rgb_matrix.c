@@ -40,7 +40,7 @@ __attribute__((weak)) RGB rgb_matrix_hsv_to_rgb(HSV hsv) {
 
 // ------------------------------------------
 // -----Begin rgb effect includes macros-----
-#define RGB_MATRIX_EFFECT(name)
+#define RGB_MATRIX_EFFECT(name, ...)
 #define RGB_MATRIX_CUSTOM_EFFECT_IMPLS
 
 #include "rgb_matrix_effects.inc"
@@ -118,6 +118,7 @@ uint8_t g_rgb_frame_buffer[MATRIX_ROWS][MATRIX_COLS] = {{0}};
 #endif // RGB_MATRIX_FRAMEBUFFER_EFFECTS
 #ifdef RGB_MATRIX_KEYREACTIVE_ENABLED
 last_hit_t g_last_hit_tracker;
+uint16_t   g_led_hit_time[DRIVER_LED_TOTAL];
 #endif // RGB_MATRIX_KEYREACTIVE_ENABLED
 
 // internals
@@ -130,6 +131,47 @@ static rgb_task_states rgb_task_state    = SYNCING;
 static uint32_t rgb_anykey_timer;
 #endif // RGB_DISABLE_TIMEOUT > 0
 
+#ifdef RGB_MATRIX_ADAPTIVE_SLICING
+#    ifndef MIN
+#        define MIN(a, b) ((a) < (b) ? (a) : (b))
+#    endif
+#    if RGB_MATRIX_LED_PROCESS_LIMIT > 0 && RGB_MATRIX_LED_PROCESS_LIMIT < DRIVER_LED_TOTAL
+#        define RGB_MATRIX_SLICE_START RGB_MATRIX_LED_PROCESS_LIMIT
+#    else
+#        define RGB_MATRIX_SLICE_START DRIVER_LED_TOTAL
+#    endif
+uint8_t g_rgb_matrix_slice = RGB_MATRIX_SLICE_START;
+
+// render cost measurement, the slice only changes between frames
+static struct {
+    uint8_t  effect;
+    uint8_t  next_slice;
+    uint8_t  frames;
+    uint16_t time;
+    uint16_t leds;
+    uint16_t cost;
+    uint16_t fps;
+    uint16_t fps_frames;
+    uint16_t fps_timer;
+} rgb_slice = {.effect = UINT8_MAX, .next_slice = RGB_MATRIX_SLICE_START};
+#endif // RGB_MATRIX_ADAPTIVE_SLICING
+
+#ifdef RGB_MATRIX_SKIP_STATIC_FRAMES
+// the state indicator callbacks draw from
+typedef struct {
+    layer_state_t layers;
+    layer_state_t default_layers;
+    uint8_t       leds;
+    uint8_t       mods;
+} rgb_indicator_state_t;
+
+// last flushed frame, kept while nothing it was rendered from changes
+static bool                  rgb_frame_valid = false;
+static uint8_t               rgb_frame_effect;
+static uint32_t              rgb_frame_config;
+static rgb_indicator_state_t rgb_frame_indicators;
+#endif // RGB_MATRIX_SKIP_STATIC_FRAMES
+
 // double buffers
 static uint32_t rgb_timer_buffer;
 #ifdef RGB_MATRIX_KEYREACTIVE_ENABLED
@@ -209,12 +251,10 @@ void rgb_matrix_set_color_all(uint8_t red, uint8_t green, uint8_t blue) {
 #endif
 }
 
-void process_rgb_matrix(uint8_t row, uint8_t col, bool pressed) {
-#ifndef RGB_MATRIX_SPLIT
-    if (!is_keyboard_master()) return;
-#endif
+/* Applies a switch event that happened tick ms ago */
+static void rgb_matrix_process_switch(uint8_t row, uint8_t col, bool pressed, uint16_t tick) {
 #if RGB_DISABLE_TIMEOUT > 0
-    rgb_anykey_timer = 0;
+    rgb_anykey_timer = tick;
 #endif // RGB_DISABLE_TIMEOUT > 0
 
 #ifdef RGB_MATRIX_KEYREACTIVE_ENABLED
@@ -243,8 +283,9 @@ void process_rgb_matrix(uint8_t row, uint8_t col, bool pressed) {
         last_hit_buffer.x[index]     = g_led_config.point[led[i]].x;
         last_hit_buffer.y[index]     = g_led_config.point[led[i]].y;
         last_hit_buffer.index[index] = led[i];
-        last_hit_buffer.tick[index]  = 0;
+        last_hit_buffer.tick[index]  = tick;
         last_hit_buffer.count++;
+        g_led_hit_time[led[i]] = sync_timer_read() - tick;
     }
 #endif // RGB_MATRIX_KEYREACTIVE_ENABLED
 
@@ -255,6 +296,48 @@ void process_rgb_matrix(uint8_t row, uint8_t col, bool pressed) {
 #endif // defined(RGB_MATRIX_FRAMEBUFFER_EFFECTS) && defined(ENABLE_RGB_MATRIX_TYPING_HEATMAP)
 }
 
+#ifdef RGB_MATRIX_SPLIT_SYNC
+static rgb_matrix_split_event_t split_events[RGB_MATRIX_SPLIT_EVENTS];
+static uint8_t                  split_event_count = 0;
+
+uint8_t rgb_matrix_split_events_get(rgb_matrix_split_event_t *events, uint8_t max) {
+    uint8_t count = split_event_count < max ? split_event_count : max;
+    memcpy(events, split_events, count * sizeof(rgb_matrix_split_event_t));
+    return count;
+}
+
+void rgb_matrix_split_events_ack(uint8_t count) {
+    split_event_count -= count;
+    memmove(&split_events[0], &split_events[count], split_event_count * sizeof(rgb_matrix_split_event_t));
+}
+
+/** \brief Replays the switch events of the master half
+ *
+ * Events carry the sync timer of the press, so the hits age the same way on
+ * both halves however late the transport delivers them.
+ */
+void rgb_matrix_split_events_put(const rgb_matrix_split_event_t *events, uint8_t count) {
+    for (uint8_t i = 0; i < count; i++) {
+        // the halves may disagree by a tick or two right after a timer sync
+        int16_t age = (int16_t)(sync_timer_read() - events[i].time);
+        rgb_matrix_process_switch(events[i].row, events[i].col, events[i].pressed, age > 0 ? age : 0);
+    }
+}
+#endif // RGB_MATRIX_SPLIT_SYNC
+
+void process_rgb_matrix(uint8_t row, uint8_t col, bool pressed) {
+#if !defined(RGB_MATRIX_SPLIT) || defined(RGB_MATRIX_SPLIT_SYNC)
+    if (!is_keyboard_master()) return;
+#endif
+#ifdef RGB_MATRIX_SPLIT_SYNC
+    if (split_event_count == RGB_MATRIX_SPLIT_EVENTS) {
+        rgb_matrix_split_events_ack(1);
+    }
+    split_events[split_event_count++] = (rgb_matrix_split_event_t){.row = row, .col = col, .pressed = pressed, .time = sync_timer_read()};
+#endif // RGB_MATRIX_SPLIT_SYNC
+    rgb_matrix_process_switch(row, col, pressed, 0);
+}
+
 void rgb_matrix_test(void) {
     // Mask out bits 4 and 5
     // Increase the factor to make the test animation slower (and reduce to make it faster)
@@ -288,6 +371,19 @@ static bool rgb_matrix_none(effect_params_t *params) {
     return false;
 }
 
+#ifdef RGB_MATRIX_KEYREACTIVE_ENABLED
+/* rgb_task_timers pins the hit times of idle LEDs one at a time, which only
+ * keeps up while the task runs. After init or a suspend, the times may be
+ * anything, so all of them are pinned at once.
+ */
+static void rgb_led_hit_times_expire(void) {
+    uint16_t now = sync_timer_read();
+    for (uint8_t i = 0; i < DRIVER_LED_TOTAL; ++i) {
+        g_led_hit_time[i] = now - RGB_MATRIX_HIT_EXPIRED;
+    }
+}
+#endif // RGB_MATRIX_KEYREACTIVE_ENABLED
+
 static void rgb_task_timers(void) {
 #if defined(RGB_MATRIX_KEYREACTIVE_ENABLED) || RGB_DISABLE_TIMEOUT > 0
     uint32_t deltaTime = sync_timer_elapsed32(rgb_timer_buffer);
@@ -303,29 +399,199 @@ static void rgb_task_timers(void) {
 
     // Update double buffer last hit timers
 #ifdef RGB_MATRIX_KEYREACTIVE_ENABLED
-    uint8_t count = last_hit_buffer.count;
-    for (uint8_t i = 0; i < count; ++i) {
+    // hits are kept oldest first, retire the ones no effect can show anymore
+    uint8_t speed  = qadd8(rgb_matrix_config.speed, 1);
+    uint8_t retire = 0;
+    for (uint8_t i = 0; i < last_hit_buffer.count; ++i) {
         if (UINT16_MAX - deltaTime < last_hit_buffer.tick[i]) {
-            last_hit_buffer.count--;
-            continue;
+            last_hit_buffer.tick[i] = UINT16_MAX;
+        } else {
+            last_hit_buffer.tick[i] += deltaTime;
         }
-        last_hit_buffer.tick[i] += deltaTime;
+        if (retire == i && (last_hit_buffer.tick[i] == UINT16_MAX || scale16by8(last_hit_buffer.tick[i], speed) >= RGB_MATRIX_HIT_DECAYED)) {
+            retire++;
+        }
+    }
+    if (retire) {
+        last_hit_buffer.count -= retire;
+        memmove(&last_hit_buffer.x[0], &last_hit_buffer.x[retire], last_hit_buffer.count);
+        memmove(&last_hit_buffer.y[0], &last_hit_buffer.y[retire], last_hit_buffer.count);
+        memmove(&last_hit_buffer.tick[0], &last_hit_buffer.tick[retire], last_hit_buffer.count * 2); // 16 bit
+        memmove(&last_hit_buffer.index[0], &last_hit_buffer.index[retire], last_hit_buffer.count);
+    }
+
+    // pin the hit times of idle LEDs before they can wrap around, one LED per run
+    static uint8_t hit_led = 0;
+    if ((uint16_t)(rgb_timer_buffer - g_led_hit_time[hit_led]) > RGB_MATRIX_HIT_EXPIRED) {
+        g_led_hit_time[hit_led] = rgb_timer_buffer - RGB_MATRIX_HIT_EXPIRED;
+    }
+    if (++hit_led >= DRIVER_LED_TOTAL) {
+        hit_led = 0;
     }
 #endif // RGB_MATRIX_KEYREACTIVE_ENABLED
 }
 
-static void rgb_task_sync(void) {
+#ifdef RGB_MATRIX_ADAPTIVE_SLICING
+/* Accounts one render iteration. Timer ticks landing inside an iteration are
+ * as likely as its length in ms, so summing them over a window gives a fair
+ * estimate even though most iterations are well below a millisecond.
+ */
+static void rgb_slice_measure(uint16_t start) {
+    if (rgb_effect_params.iter == 0) {
+        return;
+    }
+    uint8_t min = g_rgb_matrix_slice * (rgb_effect_params.iter - 1);
+    rgb_slice.time += timer_elapsed(start);
+    rgb_slice.leds += MIN(g_rgb_matrix_slice, DRIVER_LED_TOTAL - min);
+}
+
+/* Resizes the slice once per window of frames, per effect. */
+static void rgb_slice_update(uint8_t effect) {
+    rgb_slice.fps_frames++;
+    uint16_t elapsed = timer_elapsed(rgb_slice.fps_timer);
+    if (elapsed >= 1000) {
+        rgb_slice.fps        = (uint32_t)rgb_slice.fps_frames * 1000 / elapsed;
+        rgb_slice.fps_frames = 0;
+        rgb_slice.fps_timer  = timer_read();
+    }
+
+    if (effect != rgb_slice.effect) {
+        rgb_slice.effect     = effect;
+        rgb_slice.next_slice = RGB_MATRIX_SLICE_START;
+        rgb_slice.frames     = 0;
+        rgb_slice.time       = 0;
+        rgb_slice.leds       = 0;
+        return;
+    }
+    if (++rgb_slice.frames < RGB_MATRIX_SLICE_WINDOW || rgb_slice.leds == 0) {
+        return;
+    }
+
+    uint32_t cost   = (uint32_t)rgb_slice.time * 1000 / rgb_slice.leds;
+    uint32_t target = cost ? RGB_MATRIX_SLICE_BUDGET / cost : DRIVER_LED_TOTAL;
+
+    rgb_slice.cost       = MIN(cost, UINT16_MAX);
+    rgb_slice.next_slice = target < 1 ? 1 : MIN(target, DRIVER_LED_TOTAL);
+    if (rgb_slice.next_slice != g_rgb_matrix_slice) {
+        dprintf("rgb matrix: slice %u -> %u leds (%u us/led)\n", g_rgb_matrix_slice, rgb_slice.next_slice, rgb_slice.cost);
+    }
+    rgb_slice.frames = 0;
+    rgb_slice.time   = 0;
+    rgb_slice.leds   = 0;
+}
+
+void rgb_matrix_print_stats(void) {
+    xprintf("rgb matrix: %u fps, %u leds/slice, %u slices/frame, %u us/led\n", rgb_slice.fps, g_rgb_matrix_slice, (DRIVER_LED_TOTAL + g_rgb_matrix_slice - 1) / g_rgb_matrix_slice, rgb_slice.cost);
+}
+#endif // RGB_MATRIX_ADAPTIVE_SLICING
+
+#ifdef RGB_MATRIX_SKIP_STATIC_FRAMES
+static uint8_t rgb_effect_depends(uint8_t effect) {
+    switch (effect) {
+// ---------------------------------------------
+// -----Begin rgb effect depends case macros----
+#    define RGB_MATRIX_EFFECT(name, ...) \
+        case RGB_MATRIX_##name:          \
+            return RGB_MATRIX_DEPENDS_##__VA_ARGS__;
+#    include "rgb_matrix_effects.inc"
+#    undef RGB_MATRIX_EFFECT
+
+#    if defined(RGB_MATRIX_CUSTOM_KB) || defined(RGB_MATRIX_CUSTOM_USER)
+#        define RGB_MATRIX_EFFECT(name, ...) \
+            case RGB_MATRIX_CUSTOM_##name:   \
+                return RGB_MATRIX_DEPENDS_##__VA_ARGS__;
+#        ifdef RGB_MATRIX_CUSTOM_KB
+#            include "rgb_matrix_kb.inc"
+#        endif
+#        ifdef RGB_MATRIX_CUSTOM_USER
+#            include "rgb_matrix_user.inc"
+#        endif
+#        undef RGB_MATRIX_EFFECT
+#    endif
+            // -----End rgb effect depends case macros------
+            // ---------------------------------------------
+
+        default:
+            return RGB_MATRIX_DEPENDS_TIME;
+    }
+}
+
+static bool rgb_effect_is_static(uint8_t effect) {
+    switch (rgb_effect_depends(effect)) {
+        case RGB_MATRIX_DEPENDS_CONFIG:
+            return true;
+#    if FASTLED_SCALE8_FIXED != 1
+        case RGB_MATRIX_DEPENDS_SPEED:
+            // time is scaled by the speed, so it stands still at 0
+            return rgb_matrix_config.speed == 0;
+#    endif
+        default:
+            return false;
+    }
+}
+
+/* Indicators are not run to find out whether they changed, the frame is
+ * kept as long as the state they are normally drawn from stays the same.
+ * Anything else has to call rgb_matrix_invalidate_frame().
+ */
+static void rgb_indicator_state(rgb_indicator_state_t *state) {
+    memset(state, 0, sizeof(*state));
+    state->layers         = layer_state;
+    state->default_layers = default_layer_state;
+    state->leds           = host_keyboard_leds();
+    state->mods           = get_mods();
+#    ifndef NO_ACTION_ONESHOT
+    state->mods |= get_oneshot_mods();
+#    endif
+}
+
+static bool rgb_frame_is_current(uint8_t effect) {
+    if (!rgb_frame_valid || effect != rgb_frame_effect || rgb_matrix_config.raw != rgb_frame_config) {
+        return false;
+    }
+    rgb_indicator_state_t state;
+    rgb_indicator_state(&state);
+    return memcmp(&state, &rgb_frame_indicators, sizeof(state)) == 0;
+}
+
+void rgb_matrix_invalidate_frame(void) {
+    rgb_frame_valid = false;
+}
+#endif // RGB_MATRIX_SKIP_STATIC_FRAMES
+
+static void rgb_task_sync(uint8_t effect) {
     eeconfig_flush_rgb_matrix(false);
     // next task
-    if (sync_timer_elapsed32(g_rgb_timer) >= RGB_MATRIX_LED_FLUSH_LIMIT) rgb_task_state = STARTING;
+    if (sync_timer_elapsed32(g_rgb_timer) >= RGB_MATRIX_LED_FLUSH_LIMIT) {
+#ifdef RGB_MATRIX_SKIP_STATIC_FRAMES
+        if (rgb_frame_is_current(effect)) {
+            // nothing to render, check again after another flush interval
+#    ifdef RGB_MATRIX_SPLIT_SYNC
+            g_rgb_timer = rgb_timer_buffer - rgb_timer_buffer % RGB_MATRIX_LED_FLUSH_LIMIT;
+#    else
+            g_rgb_timer = rgb_timer_buffer;
+#    endif
+            return;
+        }
+#endif // RGB_MATRIX_SKIP_STATIC_FRAMES
+        rgb_task_state = STARTING;
+    }
 }
 
 static void rgb_task_start(void) {
     // reset iter
     rgb_effect_params.iter = 0;
+#ifdef RGB_MATRIX_ADAPTIVE_SLICING
+    g_rgb_matrix_slice = rgb_slice.next_slice;
+#endif
 
     // update double buffers
+#ifdef RGB_MATRIX_SPLIT_SYNC
+    // frames start on the same sync timer boundaries on both halves
+    g_rgb_timer = rgb_timer_buffer - rgb_timer_buffer % RGB_MATRIX_LED_FLUSH_LIMIT;
+#else
     g_rgb_timer = rgb_timer_buffer;
+#endif
 #ifdef RGB_MATRIX_KEYREACTIVE_ENABLED
     g_last_hit_tracker = last_hit_buffer;
 #endif // RGB_MATRIX_KEYREACTIVE_ENABLED
@@ -401,6 +667,17 @@ static void rgb_task_flush(uint8_t effect) {
 
     // update pwm buffers
     rgb_matrix_update_pwm_buffers();
+#ifdef RGB_MATRIX_SKIP_STATIC_FRAMES
+    rgb_frame_valid = effect && rgb_effect_is_static(effect);
+    if (rgb_frame_valid) {
+        rgb_frame_effect = effect;
+        rgb_frame_config = rgb_matrix_config.raw;
+        rgb_indicator_state(&rgb_frame_indicators);
+    }
+#endif // RGB_MATRIX_SKIP_STATIC_FRAMES
+#ifdef RGB_MATRIX_ADAPTIVE_SLICING
+    rgb_slice_update(effect);
+#endif
 
     // next task
     rgb_task_state = SYNCING;
@@ -423,18 +700,24 @@ void rgb_matrix_task(void) {
         case STARTING:
             rgb_task_start();
             break;
-        case RENDERING:
+        case RENDERING: {
+#ifdef RGB_MATRIX_ADAPTIVE_SLICING
+            uint16_t render_start = timer_read();
+#endif
             rgb_task_render(effect);
             if (effect) {
                 rgb_matrix_indicators();
                 rgb_matrix_indicators_advanced(&rgb_effect_params);
             }
-            break;
+#ifdef RGB_MATRIX_ADAPTIVE_SLICING
+            rgb_slice_measure(render_start);
+#endif
+        } break;
         case FLUSHING:
             rgb_task_flush(effect);
             break;
         case SYNCING:
-            rgb_task_sync();
+            rgb_task_sync(effect);
             break;
     }
 }
@@ -454,9 +737,9 @@ void rgb_matrix_indicators_advanced(effect_params_t *params) {
      * and not sure which would be better. Otherwise, this should be called from
      * rgb_task_render, right before the iter++ line.
      */
-#if defined(RGB_MATRIX_LED_PROCESS_LIMIT) && RGB_MATRIX_LED_PROCESS_LIMIT > 0 && RGB_MATRIX_LED_PROCESS_LIMIT < DRIVER_LED_TOTAL
-    uint8_t min = RGB_MATRIX_LED_PROCESS_LIMIT * (params->iter - 1);
-    uint8_t max = min + RGB_MATRIX_LED_PROCESS_LIMIT;
+#if defined(RGB_MATRIX_ADAPTIVE_SLICING) || (defined(RGB_MATRIX_LED_PROCESS_LIMIT) && RGB_MATRIX_LED_PROCESS_LIMIT > 0 && RGB_MATRIX_LED_PROCESS_LIMIT < DRIVER_LED_TOTAL)
+    uint8_t min = RGB_MATRIX_LED_SLICE * (params->iter - 1);
+    uint8_t max = min + RGB_MATRIX_LED_SLICE;
     if (max > DRIVER_LED_TOTAL) max = DRIVER_LED_TOTAL;
 #else
     uint8_t min = 0;
@@ -483,6 +766,8 @@ void rgb_matrix_init(void) {
     for (uint8_t i = 0; i < LED_HITS_TO_REMEMBER; ++i) {
         last_hit_buffer.tick[i] = UINT16_MAX;
     }
+
+    rgb_led_hit_times_expire();
 #endif // RGB_MATRIX_KEYREACTIVE_ENABLED
 
     if (!eeconfig_is_enabled()) {
@@ -507,6 +792,11 @@ void rgb_matrix_set_suspend_state(bool state) {
     }
     suspend_state = state;
 #endif
+#ifdef RGB_MATRIX_KEYREACTIVE_ENABLED
+    if (!state) {
+        rgb_led_hit_times_expire();
+    }
+#endif // RGB_MATRIX_KEYREACTIVE_ENABLED
 }
 
 bool rgb_matrix_get_suspend_state(void) {
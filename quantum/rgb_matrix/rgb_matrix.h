@@ -50,19 +50,46 @@
 #    define RGB_MATRIX_LED_PROCESS_LIMIT (DRIVER_LED_TOTAL + 4) / 5
 #endif
 
-#if defined(RGB_MATRIX_LED_PROCESS_LIMIT) && RGB_MATRIX_LED_PROCESS_LIMIT > 0 && RGB_MATRIX_LED_PROCESS_LIMIT < DRIVER_LED_TOTAL
+#ifdef RGB_MATRIX_SPLIT_SYNC
+#    if !defined(RGB_MATRIX_SPLIT) || defined(DISABLE_SYNC_TIMER)
+#        error "RGB_MATRIX_SPLIT_SYNC requires RGB_MATRIX_SPLIT and the split sync timer"
+#    endif
+#    if RGB_MATRIX_LED_FLUSH_LIMIT < 1
+#        error "RGB_MATRIX_SPLIT_SYNC requires RGB_MATRIX_LED_FLUSH_LIMIT to be at least 1"
+#    endif
+// switch events queued for the slave half between two transport runs
+#    ifndef RGB_MATRIX_SPLIT_EVENTS
+#        define RGB_MATRIX_SPLIT_EVENTS 8
+#    endif
+#endif
+
+#ifdef RGB_MATRIX_ADAPTIVE_SLICING
+// render time targeted per task run, the LEDs processed per run are sized to fit (us)
+#    ifndef RGB_MATRIX_SLICE_BUDGET
+#        define RGB_MATRIX_SLICE_BUDGET 1000
+#    endif
+// number of frames the render cost is averaged over before the slice is resized
+#    ifndef RGB_MATRIX_SLICE_WINDOW
+#        define RGB_MATRIX_SLICE_WINDOW 32
+#    endif
+#    define RGB_MATRIX_LED_SLICE g_rgb_matrix_slice
+#else
+#    define RGB_MATRIX_LED_SLICE RGB_MATRIX_LED_PROCESS_LIMIT
+#endif
+
+#if defined(RGB_MATRIX_ADAPTIVE_SLICING) || (defined(RGB_MATRIX_LED_PROCESS_LIMIT) && RGB_MATRIX_LED_PROCESS_LIMIT > 0 && RGB_MATRIX_LED_PROCESS_LIMIT < DRIVER_LED_TOTAL)
 #    if defined(RGB_MATRIX_SPLIT)
 #        define RGB_MATRIX_USE_LIMITS(min, max)                                                   \
-            uint8_t min = RGB_MATRIX_LED_PROCESS_LIMIT * params->iter;                            \
-            uint8_t max = min + RGB_MATRIX_LED_PROCESS_LIMIT;                                     \
+            uint8_t min = RGB_MATRIX_LED_SLICE * params->iter;                                    \
+            uint8_t max = min + RGB_MATRIX_LED_SLICE;                                             \
             if (max > DRIVER_LED_TOTAL) max = DRIVER_LED_TOTAL;                                   \
             uint8_t k_rgb_matrix_split[2] = RGB_MATRIX_SPLIT;                                     \
             if (is_keyboard_left() && (max > k_rgb_matrix_split[0])) max = k_rgb_matrix_split[0]; \
             if (!(is_keyboard_left()) && (min < k_rgb_matrix_split[0])) min = k_rgb_matrix_split[0];
 #    else
-#        define RGB_MATRIX_USE_LIMITS(min, max)                        \
-            uint8_t min = RGB_MATRIX_LED_PROCESS_LIMIT * params->iter; \
-            uint8_t max = min + RGB_MATRIX_LED_PROCESS_LIMIT;          \
+#        define RGB_MATRIX_USE_LIMITS(min, max)                \
+            uint8_t min = RGB_MATRIX_LED_SLICE * params->iter; \
+            uint8_t max = min + RGB_MATRIX_LED_SLICE;          \
             if (max > DRIVER_LED_TOTAL) max = DRIVER_LED_TOTAL;
 #    endif
 #else
@@ -88,6 +115,16 @@
 #define RGB_MATRIX_TEST_LED_FLAGS() \
     if (!HAS_ANY_FLAGS(g_led_config.flags[i], params->flags)) continue
 
+/* What an effect's output depends on, declared as the optional second argument
+ * of RGB_MATRIX_EFFECT(). With RGB_MATRIX_SKIP_STATIC_FRAMES, frames of effects
+ * that do not depend on time are kept until the config or the layer, host LED
+ * or modifier state changes.
+ */
+#define RGB_MATRIX_DEPENDS_TIME 0   // animated, rendered every frame (default)
+#define RGB_MATRIX_DEPENDS_SPEED 1  // animated, unless the speed is 0
+#define RGB_MATRIX_DEPENDS_CONFIG 2 // depends on rgb_matrix_config only
+#define RGB_MATRIX_DEPENDS_ RGB_MATRIX_DEPENDS_TIME
+
 enum rgb_matrix_effects {
     RGB_MATRIX_NONE = 0,
 
@@ -125,6 +162,17 @@ void rgb_matrix_set_color_all(uint8_t red, uint8_t green, uint8_t blue);
 void process_rgb_matrix(uint8_t row, uint8_t col, bool pressed);
 
 void rgb_matrix_task(void);
+#ifdef RGB_MATRIX_ADAPTIVE_SLICING
+void rgb_matrix_print_stats(void);
+#endif
+#ifdef RGB_MATRIX_SKIP_STATIC_FRAMES
+void rgb_matrix_invalidate_frame(void);
+#endif
+#ifdef RGB_MATRIX_SPLIT_SYNC
+uint8_t rgb_matrix_split_events_get(rgb_matrix_split_event_t *events, uint8_t max);
+void    rgb_matrix_split_events_ack(uint8_t count);
+void    rgb_matrix_split_events_put(const rgb_matrix_split_event_t *events, uint8_t count);
+#endif
 
 // This runs after another backlight effect and replaces
 // colors already set
@@ -259,7 +307,19 @@ extern uint32_t     g_rgb_timer;
 extern led_config_t g_led_config;
 #ifdef RGB_MATRIX_KEYREACTIVE_ENABLED
 extern last_hit_t g_last_hit_tracker;
+extern uint16_t   g_led_hit_time[DRIVER_LED_TOTAL];
+
+/* Time since the LED was last hit, as of the current frame, or UINT16_MAX if
+ * that is longer than RGB_MATRIX_HIT_EXPIRED or happened after the frame began.
+ */
+static inline uint16_t rgb_matrix_led_hit_tick(uint8_t led) {
+    uint16_t tick = (uint16_t)g_rgb_timer - g_led_hit_time[led];
+    return tick < RGB_MATRIX_HIT_EXPIRED ? tick : UINT16_MAX;
+}
 #endif
 #ifdef RGB_MATRIX_FRAMEBUFFER_EFFECTS
 extern uint8_t g_rgb_frame_buffer[MATRIX_ROWS][MATRIX_COLS];
 #endif
+#ifdef RGB_MATRIX_ADAPTIVE_SLICING
+extern uint8_t g_rgb_matrix_slice;
+#endif
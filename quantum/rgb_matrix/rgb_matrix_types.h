@@ -39,6 +39,14 @@
 #    define LED_HITS_TO_REMEMBER 8
 #endif // LED_HITS_TO_REMEMBER
 
+// scaled tick past which a hit has faded out of every built-in reactive effect
+#ifndef RGB_MATRIX_HIT_DECAYED
+#    define RGB_MATRIX_HIT_DECAYED 512
+#endif
+
+// per LED hit times older than this are treated as no hit (ms)
+#define RGB_MATRIX_HIT_EXPIRED 0xE000
+
 #ifdef RGB_MATRIX_KEYREACTIVE_ENABLED
 typedef struct PACKED {
     uint8_t  count;
@@ -49,6 +57,16 @@ typedef struct PACKED {
 } last_hit_t;
 #endif // RGB_MATRIX_KEYREACTIVE_ENABLED
 
+#ifdef RGB_MATRIX_SPLIT_SYNC
+// Switch event forwarded to the slave half, time is the low half of the sync timer
+typedef struct PACKED {
+    uint8_t  row;
+    uint8_t  col;
+    bool     pressed;
+    uint16_t time;
+} rgb_matrix_split_event_t;
+#endif // RGB_MATRIX_SPLIT_SYNC
+
 typedef enum rgb_task_states { STARTING, RENDERING, FLUSHING, SYNCING } rgb_task_states;
 
 typedef uint8_t led_flags_t;
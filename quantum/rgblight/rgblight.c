@@ -184,7 +184,7 @@ void rgblight_check_config(void) {
 
 uint32_t eeconfig_read_rgblight(void) {
 #ifdef EEPROM_ENABLE
-    return eeprom_read_dword(EECONFIG_RGBLIGHT);
+    return eeconfig_read_dword(EECONFIG_RGBLIGHT);
 #else
     return 0;
 #endif
@@ -193,7 +193,7 @@ uint32_t eeconfig_read_rgblight(void) {
 void eeconfig_update_rgblight(uint32_t val) {
 #ifdef EEPROM_ENABLE
     rgblight_check_config();
-    eeprom_update_dword(EECONFIG_RGBLIGHT, val);
+    eeconfig_update_dword(EECONFIG_RGBLIGHT, val);
 #endif
 }
 
@@ -766,8 +766,18 @@ bool rgblight_get_layer_state(uint8_t layer) {
     return (rgblight_status.enabled_layer_mask & mask) != 0;
 }
 
+#    ifdef RGBLIGHT_FRAME_TABLES
+// Enabled layers composed on their own, only rebuilt when the layers or the value they retain change
+static LED_TYPE                         layer_overlay[RGBLED_NUM];
+static uint8_t                          layer_overlay_used[(RGBLED_NUM + 7) / 8];
+static rgblight_segment_t const *const *layer_overlay_layers = NULL;
+static rgblight_layer_mask_t            layer_overlay_mask   = 0;
+static uint8_t                          layer_overlay_val    = 0;
+static bool                             layer_overlay_valid  = false;
+#    endif
+
 // Write any enabled LED layers into the buffer
-static void rgblight_layers_write(void) {
+static void rgblight_layers_render(LED_TYPE *buffer) {
 #    ifdef RGBLIGHT_LAYERS_RETAIN_VAL
     uint8_t current_val = rgblight_get_val();
 #    endif
@@ -789,12 +799,16 @@ static void rgblight_layers_write(void) {
                 break; // No more segments
             }
             // Write segment.count LEDs
-            LED_TYPE *const limit = &led[MIN(segment.index + segment.count, RGBLED_NUM)];
-            for (LED_TYPE *led_ptr = &led[segment.index]; led_ptr < limit; led_ptr++) {
+            LED_TYPE *const limit = &buffer[MIN(segment.index + segment.count, RGBLED_NUM)];
+            for (LED_TYPE *led_ptr = &buffer[segment.index]; led_ptr < limit; led_ptr++) {
 #    ifdef RGBLIGHT_LAYERS_RETAIN_VAL
                 sethsv(segment.hue, segment.sat, current_val, led_ptr);
 #    else
                 sethsv(segment.hue, segment.sat, segment.val, led_ptr);
+#    endif
+#    ifdef RGBLIGHT_FRAME_TABLES
+                uint8_t index = led_ptr - buffer;
+                layer_overlay_used[index / 8] |= 1 << (index % 8);
 #    endif
             }
             segment_ptr++;
@@ -802,6 +816,30 @@ static void rgblight_layers_write(void) {
     }
 }
 
+static void rgblight_layers_write(void) {
+#    ifdef RGBLIGHT_FRAME_TABLES
+    if (!layer_overlay_valid || layer_overlay_layers != rgblight_layers || layer_overlay_mask != rgblight_status.enabled_layer_mask
+#        ifdef RGBLIGHT_LAYERS_RETAIN_VAL
+        || layer_overlay_val != rgblight_get_val()
+#        endif
+    ) {
+        memset(layer_overlay_used, 0, sizeof(layer_overlay_used));
+        rgblight_layers_render(layer_overlay);
+        layer_overlay_layers = rgblight_layers;
+        layer_overlay_mask   = rgblight_status.enabled_layer_mask;
+        layer_overlay_val    = rgblight_get_val();
+        layer_overlay_valid  = true;
+    }
+    for (uint8_t i = 0; i < RGBLED_NUM; i++) {
+        if (layer_overlay_used[i / 8] & (1 << (i % 8))) {
+            led[i] = layer_overlay[i];
+        }
+    }
+#    else
+    rgblight_layers_render(led);
+#    endif
+}
+
 #    ifdef RGBLIGHT_LAYER_BLINK
 rgblight_layer_mask_t _blinking_layer_mask = 0;
 static uint16_t       _repeat_timer;
@@ -1166,14 +1204,94 @@ static uint8_t breathe_calc(uint8_t pos) {
 
 #endif
 
+#if defined(RGBLIGHT_FRAME_TABLES) && (defined(RGBLIGHT_EFFECT_BREATHING) || defined(RGBLIGHT_EFFECT_RAINBOW_MOOD) || defined(RGBLIGHT_EFFECT_RAINBOW_SWIRL) || defined(RGBLIGHT_EFFECT_SNAKE) || defined(RGBLIGHT_EFFECT_KNIGHT))
+#    if defined(RGBLIGHT_EFFECT_BREATHING) || defined(RGBLIGHT_EFFECT_RAINBOW_MOOD) || defined(RGBLIGHT_EFFECT_RAINBOW_SWIRL)
+#        ifndef RGBLIGHT_FRAME_TABLE_SIZE
+#            define RGBLIGHT_FRAME_TABLE_SIZE 64 // 256 or 128 or 64 or 32
+#        endif
+#        if defined(RGBLIGHT_EFFECT_SNAKE) && RGBLIGHT_FRAME_TABLE_SIZE < RGBLIGHT_EFFECT_SNAKE_LENGTH
+#            error "RGBLIGHT_FRAME_TABLE_SIZE must be at least RGBLIGHT_EFFECT_SNAKE_LENGTH"
+#        endif
+#    elif defined(RGBLIGHT_EFFECT_SNAKE)
+#        undef RGBLIGHT_FRAME_TABLE_SIZE
+#        define RGBLIGHT_FRAME_TABLE_SIZE RGBLIGHT_EFFECT_SNAKE_LENGTH
+#    else
+#        undef RGBLIGHT_FRAME_TABLE_SIZE
+#        define RGBLIGHT_FRAME_TABLE_SIZE 1
+#    endif
+// breathing positions and hues that share an entry
+#    define RGBLIGHT_FRAME_TABLE_STEP (256 / RGBLIGHT_FRAME_TABLE_SIZE)
+
+/* Colours of the running animation, so a tick only has to look them up:
+ *   breathing: one colour per RGBLIGHT_FRAME_TABLE_STEP breathing positions
+ *   rainbow mood and swirl: one colour per RGBLIGHT_FRAME_TABLE_STEP hues
+ *   snake: one colour per LED of the tail
+ *   knight: the lit colour
+ * The table is rebuilt when the mode or the configured colour changes.
+ */
+static LED_TYPE frame_table[RGBLIGHT_FRAME_TABLE_SIZE];
+static uint8_t  frame_table_mode = 0; // no animation has base mode 0, so the first lookup builds the table
+static HSV      frame_table_hsv  = {0, 0, 0};
+
+static const LED_TYPE *rgblight_frame_table(void) {
+    if (frame_table_mode == rgblight_status.base_mode && frame_table_hsv.h == rgblight_config.hue && frame_table_hsv.s == rgblight_config.sat && frame_table_hsv.v == rgblight_config.val) {
+        return frame_table;
+    }
+    frame_table_mode  = rgblight_status.base_mode;
+    frame_table_hsv.h = rgblight_config.hue;
+    frame_table_hsv.s = rgblight_config.sat;
+    frame_table_hsv.v = rgblight_config.val;
+
+    switch (frame_table_mode) {
+#    ifdef RGBLIGHT_EFFECT_BREATHING
+        case RGBLIGHT_MODE_BREATHING:
+            for (uint16_t i = 0; i < RGBLIGHT_FRAME_TABLE_SIZE; i++) {
+                sethsv(rgblight_config.hue, rgblight_config.sat, breathe_calc(i * RGBLIGHT_FRAME_TABLE_STEP), &frame_table[i]);
+            }
+            break;
+#    endif
+#    ifdef RGBLIGHT_EFFECT_RAINBOW_MOOD
+        case RGBLIGHT_MODE_RAINBOW_MOOD:
+#    endif
+#    ifdef RGBLIGHT_EFFECT_RAINBOW_SWIRL
+        case RGBLIGHT_MODE_RAINBOW_SWIRL:
+#    endif
+#    if defined(RGBLIGHT_EFFECT_RAINBOW_MOOD) || defined(RGBLIGHT_EFFECT_RAINBOW_SWIRL)
+            for (uint16_t i = 0; i < RGBLIGHT_FRAME_TABLE_SIZE; i++) {
+                sethsv(i * RGBLIGHT_FRAME_TABLE_STEP, rgblight_config.sat, rgblight_config.val, &frame_table[i]);
+            }
+            break;
+#    endif
+#    ifdef RGBLIGHT_EFFECT_SNAKE
+        case RGBLIGHT_MODE_SNAKE:
+            for (uint8_t j = 0; j < RGBLIGHT_EFFECT_SNAKE_LENGTH; j++) {
+                sethsv(rgblight_config.hue, rgblight_config.sat, (uint8_t)(rgblight_config.val * (RGBLIGHT_EFFECT_SNAKE_LENGTH - j) / RGBLIGHT_EFFECT_SNAKE_LENGTH), &frame_table[j]);
+            }
+            break;
+#    endif
+        default:
+            sethsv(rgblight_config.hue, rgblight_config.sat, rgblight_config.val, &frame_table[0]);
+            break;
+    }
+    return frame_table;
+}
+#endif
+
 // Effects
 #ifdef RGBLIGHT_EFFECT_BREATHING
 
 __attribute__((weak)) const uint8_t RGBLED_BREATHING_INTERVALS[] PROGMEM = {30, 20, 10, 5};
 
 void rgblight_effect_breathing(animation_status_t *anim) {
+#    ifdef RGBLIGHT_FRAME_TABLES
+    if (rgblight_config.enable) {
+        LED_TYPE color = rgblight_frame_table()[anim->pos / RGBLIGHT_FRAME_TABLE_STEP];
+        rgblight_setrgb(color.r, color.g, color.b);
+    }
+#    else
     uint8_t val = breathe_calc(anim->pos);
     rgblight_sethsv_noeeprom_old(rgblight_config.hue, rgblight_config.sat, val);
+#    endif
     anim->pos = (anim->pos + 1);
 }
 #endif
@@ -1182,7 +1300,14 @@ void rgblight_effect_breathing(animation_status_t *anim) {
 __attribute__((weak)) const uint8_t RGBLED_RAINBOW_MOOD_INTERVALS[] PROGMEM = {120, 60, 30};
 
 void rgblight_effect_rainbow_mood(animation_status_t *anim) {
+#    ifdef RGBLIGHT_FRAME_TABLES
+    if (rgblight_config.enable) {
+        LED_TYPE color = rgblight_frame_table()[(uint8_t)anim->current_hue / RGBLIGHT_FRAME_TABLE_STEP];
+        rgblight_setrgb(color.r, color.g, color.b);
+    }
+#    else
     rgblight_sethsv_noeeprom_old(anim->current_hue, rgblight_config.sat, rgblight_config.val);
+#    endif
     anim->current_hue++;
 }
 #endif
@@ -1197,10 +1322,17 @@ __attribute__((weak)) const uint8_t RGBLED_RAINBOW_SWIRL_INTERVALS[] PROGMEM = {
 void rgblight_effect_rainbow_swirl(animation_status_t *anim) {
     uint8_t hue;
     uint8_t i;
+#    ifdef RGBLIGHT_FRAME_TABLES
+    const LED_TYPE *colors = rgblight_frame_table();
+#    endif
 
     for (i = 0; i < rgblight_ranges.effect_num_leds; i++) {
         hue = (RGBLIGHT_RAINBOW_SWIRL_RANGE / rgblight_ranges.effect_num_leds * i + anim->current_hue);
+#    ifdef RGBLIGHT_FRAME_TABLES
+        led[i + rgblight_ranges.effect_start_pos] = colors[hue / RGBLIGHT_FRAME_TABLE_STEP];
+#    else
         sethsv(hue, rgblight_config.sat, rgblight_config.val, (LED_TYPE *)&led[i + rgblight_ranges.effect_start_pos]);
+#    endif
     }
     rgblight_set();
 
@@ -1220,6 +1352,9 @@ void rgblight_effect_snake(animation_status_t *anim) {
     uint8_t        i, j;
     int8_t         k;
     int8_t         increment = 1;
+#    ifdef RGBLIGHT_FRAME_TABLES
+    const LED_TYPE *colors = rgblight_frame_table();
+#    endif
 
     if (anim->delta % 2) {
         increment = -1;
@@ -1253,7 +1388,11 @@ void rgblight_effect_snake(animation_status_t *anim) {
                 k = k + rgblight_ranges.effect_num_leds;
             }
             if (i == k) {
+#    ifdef RGBLIGHT_FRAME_TABLES
+                *ledp = colors[j];
+#    else
                 sethsv(rgblight_config.hue, rgblight_config.sat, (uint8_t)(rgblight_config.val * (RGBLIGHT_EFFECT_SNAKE_LENGTH - j) / RGBLIGHT_EFFECT_SNAKE_LENGTH), ledp);
+#    endif
             }
         }
     }
@@ -1287,6 +1426,9 @@ void rgblight_effect_knight(animation_status_t *anim) {
     static int8_t high_bound = RGBLIGHT_EFFECT_KNIGHT_LENGTH - 1;
     static int8_t increment  = 1;
     uint8_t       i, cur;
+#    ifdef RGBLIGHT_FRAME_TABLES
+    const LED_TYPE *colors = rgblight_frame_table();
+#    endif
 
 #    if defined(RGBLIGHT_SPLIT) && !defined(RGBLIGHT_SPLIT_NO_ANIMATION_SYNC)
     if (anim->pos == 0) { // restart signal
@@ -1310,7 +1452,11 @@ void rgblight_effect_knight(animation_status_t *anim) {
         cur = (i + RGBLIGHT_EFFECT_KNIGHT_OFFSET) % rgblight_ranges.effect_num_leds + rgblight_ranges.effect_start_pos;
 
         if (i >= low_bound && i <= high_bound) {
+#    ifdef RGBLIGHT_FRAME_TABLES
+            led[cur] = colors[0];
+#    else
             sethsv(rgblight_config.hue, rgblight_config.sat, rgblight_config.val, (LED_TYPE *)&led[cur]);
+#    endif
         } else {
             led[cur].r = 0;
             led[cur].g = 0;
@@ -485,9 +485,55 @@ static void rgb_matrix_handlers_slave(matrix_row_t master_matrix[], matrix_row_t
     rgb_matrix_set_suspend_state(split_shmem->rgb_matrix_sync.rgb_suspend_state);
 }
 
-#    define TRANSACTIONS_RGB_MATRIX_MASTER() TRANSACTION_HANDLER_MASTER(rgb_matrix)
-#    define TRANSACTIONS_RGB_MATRIX_SLAVE() TRANSACTION_HANDLER_SLAVE(rgb_matrix)
-#    define TRANSACTIONS_RGB_MATRIX_REGISTRATIONS [PUT_RGB_MATRIX] = trans_initiator2target_initializer(rgb_matrix_sync),
+#    ifdef RGB_MATRIX_SPLIT_SYNC
+
+// Forwards the switch events the master saw, only when there are any
+static bool rgb_matrix_events_handlers_master(matrix_row_t master_matrix[], matrix_row_t slave_matrix[]) {
+    static uint8_t           seq = 0;
+    rgb_matrix_events_sync_t rgb_matrix_events_sync;
+
+    rgb_matrix_events_sync.count = rgb_matrix_split_events_get(rgb_matrix_events_sync.events, RGB_MATRIX_SPLIT_EVENTS);
+    if (rgb_matrix_events_sync.count == 0) {
+        return true;
+    }
+    rgb_matrix_events_sync.seq = seq + 1;
+
+    size_t length = offsetof(rgb_matrix_events_sync_t, events) + rgb_matrix_events_sync.count * sizeof(rgb_matrix_split_event_t);
+    bool   okay   = transport_write(PUT_RGB_MATRIX_EVENTS, &rgb_matrix_events_sync, length);
+    if (okay) {
+        seq = rgb_matrix_events_sync.seq;
+        rgb_matrix_split_events_ack(rgb_matrix_events_sync.count);
+    }
+    return okay;
+}
+
+static void rgb_matrix_events_handlers_slave(matrix_row_t master_matrix[], matrix_row_t slave_matrix[]) {
+    static uint8_t last_seq = 0;
+    if (last_seq != split_shmem->rgb_matrix_events_sync.seq) {
+        last_seq = split_shmem->rgb_matrix_events_sync.seq;
+        rgb_matrix_split_events_put(split_shmem->rgb_matrix_events_sync.events, split_shmem->rgb_matrix_events_sync.count);
+    }
+}
+
+// clang-format off
+#        define TRANSACTIONS_RGB_MATRIX_MASTER() \
+    TRANSACTION_HANDLER_MASTER(rgb_matrix);    \
+    TRANSACTION_HANDLER_MASTER(rgb_matrix_events)
+#        define TRANSACTIONS_RGB_MATRIX_SLAVE() \
+    TRANSACTION_HANDLER_SLAVE(rgb_matrix);     \
+    TRANSACTION_HANDLER_SLAVE(rgb_matrix_events)
+#        define TRANSACTIONS_RGB_MATRIX_REGISTRATIONS \
+    [PUT_RGB_MATRIX]        = trans_initiator2target_initializer(rgb_matrix_sync), \
+    [PUT_RGB_MATRIX_EVENTS] = trans_initiator2target_initializer(rgb_matrix_events_sync),
+// clang-format on
+
+#    else // RGB_MATRIX_SPLIT_SYNC
+
+#        define TRANSACTIONS_RGB_MATRIX_MASTER() TRANSACTION_HANDLER_MASTER(rgb_matrix)
+#        define TRANSACTIONS_RGB_MATRIX_SLAVE() TRANSACTION_HANDLER_SLAVE(rgb_matrix)
+#        define TRANSACTIONS_RGB_MATRIX_REGISTRATIONS [PUT_RGB_MATRIX] = trans_initiator2target_initializer(rgb_matrix_sync),
+
+#    endif // RGB_MATRIX_SPLIT_SYNC
 
 #else // defined(RGB_MATRIX_ENABLE) && defined(RGB_MATRIX_SPLIT)
 
@@ -94,6 +94,14 @@ typedef struct _rgb_matrix_sync_t {
     rgb_config_t rgb_matrix;
     bool         rgb_suspend_state;
 } rgb_matrix_sync_t;
+
+#    ifdef RGB_MATRIX_SPLIT_SYNC
+typedef struct _rgb_matrix_events_sync_t {
+    uint8_t                  seq;
+    uint8_t                  count;
+    rgb_matrix_split_event_t events[RGB_MATRIX_SPLIT_EVENTS];
+} rgb_matrix_events_sync_t;
+#    endif // RGB_MATRIX_SPLIT_SYNC
 #endif // defined(RGB_MATRIX_ENABLE) && defined(RGB_MATRIX_SPLIT)
 
 #ifdef SPLIT_MODS_ENABLE
@@ -168,6 +176,9 @@ typedef struct _split_shared_memory_t {
 
 #if defined(RGB_MATRIX_ENABLE) && defined(RGB_MATRIX_SPLIT)
     rgb_matrix_sync_t rgb_matrix_sync;
+#    ifdef RGB_MATRIX_SPLIT_SYNC
+    rgb_matrix_events_sync_t rgb_matrix_events_sync;
+#    endif // RGB_MATRIX_SPLIT_SYNC
 #endif // defined(RGB_MATRIX_ENABLE) && defined(RGB_MATRIX_SPLIT)
 
 #if defined(WPM_ENABLE) && defined(SPLIT_WPM_ENABLE)
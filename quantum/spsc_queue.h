@@ -0,0 +1,166 @@
+/* Copyright 2022 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Single producer, single consumer queue
+ *
+ * SPSC_QUEUE(name, type, size); defines a queue and the functions below, all
+ * prefixed with name_. One side pushes while the other pops, for example an
+ * interrupt handler and the main loop, without masking interrupts. Each
+ * index is a single byte written by one side only. The barriers keep the
+ * element accesses between reading the other side's index and publishing
+ * its own.
+ *
+ * size has to be a power of two up to 128. The indices run freely and are
+ * masked when the buffer is accessed, so all size slots are usable.
+ *
+ * Producer:
+ *   bool     name_push(type item)
+ *   uint8_t  name_push_n(const type *items, uint8_t count)  returns the number pushed
+ *   type    *name_reserve(uint8_t *count)  contiguous free slots to fill in place
+ *   void     name_commit(uint8_t count)    publishes count reserved slots
+ *
+ * Consumer:
+ *   bool        name_pop(type *item)
+ *   uint8_t     name_pop_n(type *items, uint8_t count)  returns the number popped
+ *   const type *name_peek(uint8_t *count)  contiguous queued items to read in place
+ *   void        name_release(uint8_t count)  frees count peeked items
+ *   void        name_clear(void)
+ *
+ * Either side:
+ *   uint8_t name_size(void)
+ *   bool    name_empty(void)
+ */
+
+#if defined(__ARM_ARCH) && __ARM_ARCH >= 6
+#    define SPSC_BARRIER() __asm__ volatile("dmb" ::: "memory")
+#else
+#    define SPSC_BARRIER() __asm__ volatile("" ::: "memory")
+#endif
+
+#ifdef __cplusplus
+#    define SPSC_STATIC_ASSERT static_assert
+#else
+#    define SPSC_STATIC_ASSERT _Static_assert
+#endif
+
+// clang-format off
+#define SPSC_QUEUE(name, type, size)                                                          \
+    static type             name##_buffer[size];                                              \
+    static volatile uint8_t name##_head = 0; /* written by the producer only */               \
+    static volatile uint8_t name##_tail = 0; /* written by the consumer only */               \
+                                                                                              \
+    static inline uint8_t name##_size(void) {                                                 \
+        return (uint8_t)(name##_head - name##_tail);                                          \
+    }                                                                                         \
+    static inline bool name##_empty(void) {                                                   \
+        return name##_head == name##_tail;                                                    \
+    }                                                                                         \
+                                                                                              \
+    static inline type *name##_reserve(uint8_t *count) {                                      \
+        uint8_t head       = name##_head;                                                     \
+        uint8_t space      = (size) - (uint8_t)(head - name##_tail);                          \
+        uint8_t contiguous = (size) - (head & ((size) - 1));                                  \
+        SPSC_BARRIER();                                                                       \
+        *count = space < contiguous ? space : contiguous;                                     \
+        return &name##_buffer[head & ((size) - 1)];                                           \
+    }                                                                                         \
+    static inline void name##_commit(uint8_t count) {                                         \
+        SPSC_BARRIER();                                                                       \
+        name##_head = name##_head + count;                                                    \
+    }                                                                                         \
+    static inline bool name##_push(type item) {                                               \
+        uint8_t count;                                                                        \
+        type   *slot = name##_reserve(&count);                                                \
+        if (!count) {                                                                         \
+            return false;                                                                     \
+        }                                                                                     \
+        *slot = item;                                                                         \
+        name##_commit(1);                                                                     \
+        return true;                                                                          \
+    }                                                                                         \
+    static inline uint8_t name##_push_n(const type *items, uint8_t count) {                   \
+        uint8_t done = 0;                                                                     \
+        while (done < count) {                                                                \
+            uint8_t n;                                                                        \
+            type   *slot = name##_reserve(&n);                                                \
+            if (!n) {                                                                         \
+                break;                                                                        \
+            }                                                                                 \
+            if (n > count - done) {                                                           \
+                n = count - done;                                                             \
+            }                                                                                 \
+            for (uint8_t i = 0; i < n; i++) {                                                 \
+                slot[i] = items[done + i];                                                    \
+            }                                                                                 \
+            name##_commit(n);                                                                 \
+            done += n;                                                                        \
+        }                                                                                     \
+        return done;                                                                          \
+    }                                                                                         \
+                                                                                              \
+    static inline const type *name##_peek(uint8_t *count) {                                   \
+        uint8_t tail       = name##_tail;                                                     \
+        uint8_t used       = (uint8_t)(name##_head - tail);                                   \
+        uint8_t contiguous = (size) - (tail & ((size) - 1));                                  \
+        SPSC_BARRIER();                                                                       \
+        *count = used < contiguous ? used : contiguous;                                       \
+        return &name##_buffer[tail & ((size) - 1)];                                           \
+    }                                                                                         \
+    static inline void name##_release(uint8_t count) {                                        \
+        SPSC_BARRIER();                                                                       \
+        name##_tail = name##_tail + count;                                                    \
+    }                                                                                         \
+    static inline bool name##_pop(type *item) {                                               \
+        uint8_t     count;                                                                    \
+        const type *slot = name##_peek(&count);                                               \
+        if (!count) {                                                                         \
+            return false;                                                                     \
+        }                                                                                     \
+        *item = *slot;                                                                        \
+        name##_release(1);                                                                    \
+        return true;                                                                          \
+    }                                                                                         \
+    static inline uint8_t name##_pop_n(type *items, uint8_t count) {                          \
+        uint8_t done = 0;                                                                     \
+        while (done < count) {                                                                \
+            uint8_t     n;                                                                    \
+            const type *slot = name##_peek(&n);                                               \
+            if (!n) {                                                                         \
+                break;                                                                        \
+            }                                                                                 \
+            if (n > count - done) {                                                           \
+                n = count - done;                                                             \
+            }                                                                                 \
+            for (uint8_t i = 0; i < n; i++) {                                                 \
+                items[done + i] = slot[i];                                                    \
+            }                                                                                 \
+            name##_release(n);                                                                \
+            done += n;                                                                        \
+        }                                                                                     \
+        return done;                                                                          \
+    }                                                                                         \
+    static inline void name##_clear(void) {                                                   \
+        name##_tail = name##_head;                                                            \
+    }                                                                                         \
+                                                                                              \
+    SPSC_STATIC_ASSERT((size) >= 2 && (size) <= 128 && ((size) & ((size) - 1)) == 0,         \
+                       #name " size must be a power of two between 2 and 128")
+// clang-format on
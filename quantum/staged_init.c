@@ -0,0 +1,196 @@
+/* Copyright 2022 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "staged_init.h"
+#include "quantum.h"
+#include "timer.h"
+#include "print.h"
+#include "debug.h"
+#ifdef PS2_MOUSE_ENABLE
+#    include "ps2_mouse.h"
+#endif
+#ifdef POINTING_DEVICE_ENABLE
+#    include "pointing_device.h"
+#endif
+#ifdef OLED_ENABLE
+#    include "oled_driver.h"
+#endif
+#ifdef ST7565_ENABLE
+#    include "st7565.h"
+#endif
+
+#if defined(PROTOCOL_CHIBIOS)
+#    include <ch.h>
+#elif defined(__AVR__)
+#    include <util/atomic.h>
+#    include "timer_avr.h"
+#endif
+
+/* Only the matrix, keymap state and the host connection are set up before the
+ * first scan. The slower subsystems are initialised from the main loop instead,
+ * one step per keyboard_task() in the order of this table, and the remaining
+ * tasks only start once all of them ran. keyboard_post_init_kb() comes last as
+ * it usually configures the subsystems above.
+ */
+
+typedef struct {
+    const char *name;
+    void (*init)(void);
+} staged_init_step_t;
+
+#ifdef BACKLIGHT_ENABLE
+static void init_backlight(void) {
+    backlight_init_ports();
+    backlight_init();
+}
+#endif
+#ifdef OLED_ENABLE
+static void init_oled(void) {
+    oled_init(OLED_ROTATION_0);
+}
+#endif
+#ifdef ST7565_ENABLE
+static void init_st7565(void) {
+    st7565_init(DISPLAY_ROTATION_0);
+}
+#endif
+
+static const staged_init_step_t steps[] = {
+#ifdef POINTING_DEVICE_ENABLE
+    {"pointing_device", pointing_device_init},
+#endif
+#ifdef PS2_MOUSE_ENABLE
+    {"ps2_mouse", ps2_mouse_init},
+#endif
+#ifdef BACKLIGHT_ENABLE
+    {"backlight", init_backlight},
+#endif
+#ifdef RGBLIGHT_ENABLE
+    {"rgblight", rgblight_init},
+#endif
+#ifdef LED_MATRIX_ENABLE
+    {"led_matrix", led_matrix_init},
+#endif
+#ifdef RGB_MATRIX_ENABLE
+    {"rgb_matrix", rgb_matrix_init},
+#endif
+#ifdef HAPTIC_ENABLE
+    {"haptic", haptic_init},
+#endif
+#ifdef AUDIO_ENABLE
+    {"audio", audio_init},
+#endif
+#ifdef OLED_ENABLE
+    {"oled", init_oled},
+#endif
+#ifdef ST7565_ENABLE
+    {"st7565", init_st7565},
+#endif
+    {"post_init", keyboard_post_init_kb},
+    {NULL, NULL},
+};
+
+#define STEP_COUNT (sizeof(steps) / sizeof(steps[0]) - 1)
+
+/* Step durations are measured with the finest clock available: the system
+ * tick on ChibiOS, the timer 0 counter on AVR, milliseconds elsewhere.
+ */
+#if defined(PROTOCOL_CHIBIOS)
+typedef systime_t boot_clock_t;
+
+static inline boot_clock_t boot_clock(void) {
+    return chVTGetSystemTimeX();
+}
+static inline uint32_t boot_clock_us(boot_clock_t start) {
+    return TIME_I2US(chTimeDiffX(start, chVTGetSystemTimeX()));
+}
+#else
+typedef uint32_t boot_clock_t;
+
+static inline boot_clock_t boot_clock(void) {
+#    if defined(__AVR__)
+    uint32_t ms;
+    uint8_t  raw;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        ms  = timer_read32();
+        raw = TIMER_RAW;
+    }
+    return ms * 1000 + raw * 1000UL / TIMER_RAW_TOP;
+#    else
+    return timer_read32() * 1000;
+#    endif
+}
+static inline uint32_t boot_clock_us(boot_clock_t start) {
+    return boot_clock() - start;
+}
+#endif
+
+static boot_clock_t boot_start;
+static uint32_t     critical_us;
+static uint32_t     first_scan_ms;
+static uint32_t     done_ms;
+static uint32_t     step_us[STEP_COUNT];
+static uint8_t      next_step = 0;
+
+/** \brief Marks the start of keyboard_init()
+ */
+void staged_init_begin(void) {
+    boot_start = boot_clock();
+}
+
+/** \brief Marks the end of the critical part of keyboard_init()
+ */
+void staged_init_end(void) {
+    critical_us = boot_clock_us(boot_start);
+}
+
+bool staged_init_is_done(void) {
+    return next_step >= STEP_COUNT;
+}
+
+/** \brief Runs the next deferred init step
+ *
+ * Called after each matrix scan, returns true once every step has run.
+ */
+bool staged_init_task(void) {
+    if (staged_init_is_done()) {
+        return true;
+    }
+    if (next_step == 0) {
+        first_scan_ms = timer_read32();
+    }
+
+    boot_clock_t start = boot_clock();
+    steps[next_step].init();
+    step_us[next_step] = boot_clock_us(start);
+    next_step++;
+
+    if (!staged_init_is_done()) {
+        return false;
+    }
+    done_ms = timer_read32();
+    if (debug_enable) {
+        staged_init_print();
+    }
+    return true;
+}
+
+void staged_init_print(void) {
+    xprintf("boot: critical %luus, first scan at %lums, done at %lums\n", critical_us, first_scan_ms, done_ms);
+    for (uint8_t i = 0; i < STEP_COUNT; i++) {
+        xprintf("%-16s %8luus%s\n", steps[i].name, step_us[i], i < next_step ? "" : " (pending)");
+    }
+}
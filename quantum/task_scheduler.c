@@ -0,0 +1,158 @@
+/* Copyright 2022 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "task_scheduler.h"
+#include "timer.h"
+#include "print.h"
+#ifdef RGBLIGHT_ENABLE
+#    include "rgblight.h"
+#endif
+#ifdef LED_MATRIX_ENABLE
+#    include "led_matrix.h"
+#endif
+#ifdef RGB_MATRIX_ENABLE
+#    include "rgb_matrix.h"
+#endif
+#ifdef OLED_ENABLE
+#    include "oled_driver.h"
+#endif
+#ifdef ST7565_ENABLE
+#    include "st7565.h"
+#endif
+
+#ifndef MIN
+#    define MIN(a, b) (((a) < (b)) ? (a) : (b))
+#endif
+#ifndef MAX
+#    define MAX(a, b) (((a) > (b)) ? (a) : (b))
+#endif
+
+/* The render tasks are the expensive part of keyboard_task(), so instead of
+ * running all of them after every matrix scan they share a slice budget. The
+ * first task that is due always runs. Any further task is deferred to a later
+ * slice when the slice is used up or its last run would not fit in what is
+ * left. Slices start with the task after the last one that ran, so every task
+ * gets its turn.
+ *
+ * Each task also has a budget of its own, the time it may use per slice on
+ * average. It is given that much credit every slice, up to its budget, and
+ * each run costs the time it took. A task that is out of credit is deferred,
+ * so a render that takes 4ms with a 1ms budget runs at most every 4th slice.
+ *
+ * No task is deferred more than TASK_SCHEDULER_MAX_DEFER times in a row.
+ */
+
+typedef struct {
+    const char *name;
+    void (*task)(void);
+    uint16_t period;
+    uint16_t budget;
+} scheduled_task_t;
+
+typedef struct {
+    uint32_t runs;
+    uint32_t deferred;
+    uint16_t last_time;
+    uint16_t max_time;
+} task_scheduler_stats_t;
+
+static const scheduled_task_t tasks[] = {
+#ifdef RGBLIGHT_ENABLE
+    {"rgblight", rgblight_task, RGBLIGHT_TASK_PERIOD, RGBLIGHT_TASK_BUDGET},
+#endif
+#ifdef LED_MATRIX_ENABLE
+    {"led_matrix", led_matrix_task, LED_MATRIX_TASK_PERIOD, LED_MATRIX_TASK_BUDGET},
+#endif
+#ifdef RGB_MATRIX_ENABLE
+    {"rgb_matrix", rgb_matrix_task, RGB_MATRIX_TASK_PERIOD, RGB_MATRIX_TASK_BUDGET},
+#endif
+#ifdef OLED_ENABLE
+    {"oled", oled_task, OLED_TASK_PERIOD, OLED_TASK_BUDGET},
+#endif
+#ifdef ST7565_ENABLE
+    {"st7565", st7565_task, ST7565_TASK_PERIOD, ST7565_TASK_BUDGET},
+#endif
+    {NULL, NULL, 0, 0},
+};
+
+#define TASK_COUNT (sizeof(tasks) / sizeof(tasks[0]) - 1)
+
+static task_scheduler_stats_t stats[TASK_COUNT + 1];
+static uint32_t               last_run[TASK_COUNT + 1];
+static uint8_t                defer_count[TASK_COUNT + 1];
+static int16_t                credit[TASK_COUNT + 1];
+static uint8_t                next_task = 0;
+
+/** \brief Runs the render tasks that fit in this slice
+ *
+ * Called once per keyboard_task(), right after the matrix scan.
+ */
+void task_scheduler_task(void) {
+    uint32_t slice_start = timer_read32();
+    uint8_t  start       = next_task;
+    uint8_t  next        = start;
+    bool     ran         = false;
+
+    for (uint8_t i = 0; i < TASK_COUNT; i++) {
+        credit[i] = MIN(credit[i] + tasks[i].budget, tasks[i].budget);
+    }
+
+    for (uint8_t n = 0; n < TASK_COUNT; n++) {
+        uint8_t  i   = start + n < TASK_COUNT ? start + n : start + n - TASK_COUNT;
+        uint32_t now = timer_read32();
+
+        if (tasks[i].period && TIMER_DIFF_32(now, last_run[i]) < tasks[i].period) {
+            continue;
+        }
+
+        uint32_t used       = TIMER_DIFF_32(now, slice_start);
+        bool     over_slice = ran && (used >= TASK_SCHEDULER_SLICE_BUDGET || used + stats[i].last_time > TASK_SCHEDULER_SLICE_BUDGET);
+        if (defer_count[i] < TASK_SCHEDULER_MAX_DEFER && (over_slice || credit[i] <= 0)) {
+            defer_count[i]++;
+            stats[i].deferred++;
+            continue;
+        }
+
+        tasks[i].task();
+        ran = true;
+
+        uint16_t took      = TIMER_DIFF_32(timer_read32(), now);
+        last_run[i]        = now;
+        defer_count[i]     = 0;
+        credit[i]          = MAX(credit[i] - took, -TASK_SCHEDULER_MAX_DEFER * tasks[i].budget); // no more debt than max defer repays
+        stats[i].last_time = took;
+        stats[i].max_time  = MAX(stats[i].max_time, took);
+        stats[i].runs++;
+        next = i + 1 < TASK_COUNT ? i + 1 : 0;
+    }
+
+    // the next slice starts after the last task that ran
+    next_task = next;
+}
+
+void task_scheduler_reset_stats(void) {
+    for (uint8_t i = 0; i < TASK_COUNT; i++) {
+        // last_time is kept, the next slice still needs it
+        stats[i] = (task_scheduler_stats_t){.last_time = stats[i].last_time};
+    }
+}
+
+void task_scheduler_print(void) {
+    xprintf("task scheduler, since last status: slice %ums, max defer %u\n", TASK_SCHEDULER_SLICE_BUDGET, TASK_SCHEDULER_MAX_DEFER);
+    for (uint8_t i = 0; i < TASK_COUNT; i++) {
+        xprintf("%-10s budget:%ums runs:%lu deferred:%lu last:%ums max:%ums\n", tasks[i].name, tasks[i].budget, stats[i].runs, stats[i].deferred, stats[i].last_time, stats[i].max_time);
+    }
+}
@@ -0,0 +1,69 @@
+/* Copyright 2022 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* time the deferrable tasks may use after each matrix scan (ms) */
+#ifndef TASK_SCHEDULER_SLICE_BUDGET
+#    define TASK_SCHEDULER_SLICE_BUDGET 1
+#endif
+
+/* consecutive slices a task may be deferred before it is run regardless of the budget */
+#ifndef TASK_SCHEDULER_MAX_DEFER
+#    define TASK_SCHEDULER_MAX_DEFER 8
+#endif
+
+/* minimum time between two runs of each task (ms), 0 runs it on every slice */
+#ifndef RGBLIGHT_TASK_PERIOD
+#    define RGBLIGHT_TASK_PERIOD 0
+#endif
+#ifndef LED_MATRIX_TASK_PERIOD
+#    define LED_MATRIX_TASK_PERIOD 0
+#endif
+#ifndef RGB_MATRIX_TASK_PERIOD
+#    define RGB_MATRIX_TASK_PERIOD 0
+#endif
+#ifndef OLED_TASK_PERIOD
+#    define OLED_TASK_PERIOD 0
+#endif
+#ifndef ST7565_TASK_PERIOD
+#    define ST7565_TASK_PERIOD 0
+#endif
+
+/* average time each task may use per slice (ms) */
+#ifndef RGBLIGHT_TASK_BUDGET
+#    define RGBLIGHT_TASK_BUDGET TASK_SCHEDULER_SLICE_BUDGET
+#endif
+#ifndef LED_MATRIX_TASK_BUDGET
+#    define LED_MATRIX_TASK_BUDGET TASK_SCHEDULER_SLICE_BUDGET
+#endif
+#ifndef RGB_MATRIX_TASK_BUDGET
+#    define RGB_MATRIX_TASK_BUDGET TASK_SCHEDULER_SLICE_BUDGET
+#endif
+#ifndef OLED_TASK_BUDGET
+#    define OLED_TASK_BUDGET TASK_SCHEDULER_SLICE_BUDGET
+#endif
+#ifndef ST7565_TASK_BUDGET
+#    define ST7565_TASK_BUDGET TASK_SCHEDULER_SLICE_BUDGET
+#endif
+
+void task_scheduler_task(void);
+
+void task_scheduler_print(void);
+void task_scheduler_reset_stats(void);
@@ -0,0 +1,14 @@
+spsc_queue_DEFS := -DNO_DEBUG
+
+spsc_queue_SRC := \
+	$(QUANTUM_PATH)/tests/spsc_queue_tests.cpp
+
+task_scheduler_DEFS := -DNO_PRINT -DRGBLIGHT_ENABLE -DLED_MATRIX_ENABLE -DRGB_MATRIX_ENABLE
+
+task_scheduler_INC := \
+	$(QUANTUM_PATH)/tests/task_scheduler_mock
+
+task_scheduler_SRC := \
+	$(QUANTUM_PATH)/tests/task_scheduler_tests.cpp \
+	$(QUANTUM_PATH)/task_scheduler.c \
+	$(PLATFORM_PATH)/$(PLATFORM_KEY)/timer.c
@@ -0,0 +1,190 @@
+/* Copyright 2022 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gtest/gtest.h"
+
+extern "C" {
+#include "spsc_queue.h"
+}
+
+#define QUEUE_SIZE 8
+
+SPSC_QUEUE(queue, uint16_t, QUEUE_SIZE);
+
+class SpscQueue : public ::testing::Test {
+   protected:
+    uint16_t next_in  = 0;
+    uint16_t next_out = 0;
+
+    void SetUp() override {
+        queue_clear();
+    }
+
+    // moves both indices on until the next push lands at slot
+    void advance_to(uint8_t slot) {
+        uint16_t item;
+        while ((queue_head & (QUEUE_SIZE - 1)) != slot) {
+            ASSERT_TRUE(queue_push(0));
+            ASSERT_TRUE(queue_pop(&item));
+        }
+    }
+};
+
+TEST_F(SpscQueue, StartsEmpty) {
+    uint16_t    item;
+    uint8_t     count;
+    const auto *slot = queue_peek(&count);
+
+    EXPECT_TRUE(queue_empty());
+    EXPECT_EQ(queue_size(), 0);
+    EXPECT_FALSE(queue_pop(&item));
+    EXPECT_EQ(queue_pop_n(&item, 1), 0);
+    EXPECT_NE(slot, nullptr);
+    EXPECT_EQ(count, 0);
+}
+
+TEST_F(SpscQueue, FullAfterSizeItems) {
+    uint16_t item;
+    uint8_t  count;
+
+    for (uint16_t i = 0; i < QUEUE_SIZE; i++) {
+        EXPECT_TRUE(queue_push(i));
+    }
+    EXPECT_FALSE(queue_push(QUEUE_SIZE));
+    EXPECT_EQ(queue_push_n(&item, 1), 0);
+    queue_reserve(&count);
+    EXPECT_EQ(count, 0);
+    EXPECT_EQ(queue_size(), QUEUE_SIZE);
+    EXPECT_FALSE(queue_empty());
+
+    for (uint16_t i = 0; i < QUEUE_SIZE; i++) {
+        EXPECT_TRUE(queue_pop(&item));
+        EXPECT_EQ(item, i);
+    }
+    EXPECT_TRUE(queue_empty());
+    EXPECT_FALSE(queue_pop(&item));
+}
+
+TEST_F(SpscQueue, IndicesWrapPast256) {
+    uint16_t item;
+
+    // keep the queue part full while the indices run around several times
+    for (uint8_t i = 0; i < QUEUE_SIZE / 2; i++) {
+        ASSERT_TRUE(queue_push(next_in++));
+    }
+    for (uint16_t i = 0; i < 1000; i++) {
+        ASSERT_TRUE(queue_push(next_in++));
+        ASSERT_EQ(queue_size(), QUEUE_SIZE / 2 + 1);
+        ASSERT_TRUE(queue_pop(&item));
+        ASSERT_EQ(item, next_out++);
+    }
+
+    // still full at exactly size items, whatever the raw index values
+    while (queue_push(next_in)) {
+        next_in++;
+    }
+    EXPECT_EQ(queue_size(), QUEUE_SIZE);
+    while (queue_pop(&item)) {
+        EXPECT_EQ(item, next_out++);
+    }
+    EXPECT_EQ(next_in, next_out);
+    EXPECT_TRUE(queue_empty());
+}
+
+TEST_F(SpscQueue, PushNPopNAcrossBufferEnd) {
+    const uint16_t in[6] = {10, 11, 12, 13, 14, 15};
+    uint16_t       out[6];
+    uint8_t        count;
+
+    advance_to(QUEUE_SIZE - 3);
+
+    // the first reserve only reaches the end of the buffer
+    queue_reserve(&count);
+    EXPECT_EQ(count, 3);
+
+    EXPECT_EQ(queue_push_n(in, 6), 6);
+    EXPECT_EQ(queue_size(), 6);
+
+    queue_peek(&count);
+    EXPECT_EQ(count, 3);
+
+    EXPECT_EQ(queue_pop_n(out, 6), 6);
+    for (uint8_t i = 0; i < 6; i++) {
+        EXPECT_EQ(out[i], in[i]);
+    }
+    EXPECT_TRUE(queue_empty());
+}
+
+TEST_F(SpscQueue, PushNStopsWhenFull) {
+    const uint16_t in[QUEUE_SIZE + 2] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+    uint16_t       out[QUEUE_SIZE + 2];
+
+    advance_to(5);
+    EXPECT_TRUE(queue_push(100));
+
+    EXPECT_EQ(queue_push_n(in, QUEUE_SIZE + 2), QUEUE_SIZE - 1);
+    EXPECT_EQ(queue_size(), QUEUE_SIZE);
+
+    EXPECT_EQ(queue_pop_n(out, QUEUE_SIZE + 2), QUEUE_SIZE);
+    EXPECT_EQ(out[0], 100);
+    for (uint8_t i = 1; i < QUEUE_SIZE; i++) {
+        EXPECT_EQ(out[i], in[i - 1]);
+    }
+    EXPECT_TRUE(queue_empty());
+}
+
+TEST_F(SpscQueue, ReserveAndPeekInPlace) {
+    uint8_t count;
+
+    advance_to(QUEUE_SIZE - 2);
+
+    uint16_t *slot = queue_reserve(&count);
+    ASSERT_EQ(count, 2);
+    slot[0] = 1;
+    slot[1] = 2;
+    queue_commit(2);
+
+    slot = queue_reserve(&count);
+    ASSERT_EQ(count, QUEUE_SIZE - 2);
+    slot[0] = 3;
+    queue_commit(1);
+
+    const uint16_t *items = queue_peek(&count);
+    ASSERT_EQ(count, 2);
+    EXPECT_EQ(items[0], 1);
+    EXPECT_EQ(items[1], 2);
+    queue_release(2);
+
+    items = queue_peek(&count);
+    ASSERT_EQ(count, 1);
+    EXPECT_EQ(items[0], 3);
+    queue_release(1);
+    EXPECT_TRUE(queue_empty());
+}
+
+TEST_F(SpscQueue, ClearDropsQueuedItems) {
+    for (uint16_t i = 0; i < 5; i++) {
+        queue_push(i);
+    }
+    queue_clear();
+    EXPECT_TRUE(queue_empty());
+    EXPECT_EQ(queue_size(), 0);
+
+    uint16_t item;
+    EXPECT_TRUE(queue_push(42));
+    EXPECT_TRUE(queue_pop(&item));
+    EXPECT_EQ(item, 42);
+}
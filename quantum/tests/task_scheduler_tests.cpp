@@ -0,0 +1,108 @@
+/* Copyright 2022 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gtest/gtest.h"
+#include <algorithm>
+#include <vector>
+
+extern "C" {
+#include "task_scheduler.h"
+#include "timer.h"
+
+void advance_time(uint32_t ms);
+}
+
+#define TASK_COUNT 3
+
+enum { RGBLIGHT, LED_MATRIX, RGB_MATRIX };
+
+static std::vector<int> runs;
+static uint32_t         task_time[TASK_COUNT];
+
+static void run_task(int task) {
+    runs.push_back(task);
+    advance_time(task_time[task]);
+}
+
+extern "C" {
+void rgblight_task(void) {
+    run_task(RGBLIGHT);
+}
+void led_matrix_task(void) {
+    run_task(LED_MATRIX);
+}
+void rgb_matrix_task(void) {
+    run_task(RGB_MATRIX);
+}
+}
+
+class TaskScheduler : public ::testing::Test {
+   protected:
+    void SetUp() override {
+        runs.clear();
+        task_scheduler_reset_stats();
+    }
+
+    void run_slices(uint16_t count) {
+        for (uint16_t i = 0; i < count; i++) {
+            task_scheduler_task();
+            advance_time(1); // the matrix scan between slices
+        }
+    }
+
+    // every window of TASK_COUNT runs holds each task once, in round robin order
+    void expect_round_robin(void) {
+        ASSERT_GE(runs.size(), TASK_COUNT);
+        for (size_t i = 1; i < runs.size(); i++) {
+            EXPECT_EQ(runs[i], (runs[i - 1] + 1) % TASK_COUNT) << "at run " << i;
+        }
+    }
+};
+
+TEST_F(TaskScheduler, CheapTasksAllRunEverySlice) {
+    task_time[RGBLIGHT] = task_time[LED_MATRIX] = task_time[RGB_MATRIX] = 0;
+
+    run_slices(100);
+
+    EXPECT_EQ(runs.size(), 100 * TASK_COUNT);
+    expect_round_robin();
+    for (int task = 0; task < TASK_COUNT; task++) {
+        EXPECT_EQ(std::count(runs.begin(), runs.end(), task), 100);
+    }
+}
+
+TEST_F(TaskScheduler, SliceSizedTasksTakeTurns) {
+    task_time[RGBLIGHT] = task_time[LED_MATRIX] = task_time[RGB_MATRIX] = TASK_SCHEDULER_SLICE_BUDGET;
+
+    run_slices(99);
+
+    // one task fits per slice, so each one runs once per round of three slices
+    EXPECT_EQ(runs.size(), 99);
+    expect_round_robin();
+    for (int task = 0; task < TASK_COUNT; task++) {
+        EXPECT_EQ(std::count(runs.begin(), runs.end(), task), 33);
+    }
+}
+
+TEST_F(TaskScheduler, TwoSliceTasksStillRunOncePerRound) {
+    task_time[RGBLIGHT] = task_time[LED_MATRIX] = task_time[RGB_MATRIX] = 2 * TASK_SCHEDULER_SLICE_BUDGET;
+
+    run_slices(300);
+
+    // over their own budget, so they are also held back by credit, but never skipped in turn
+    ASSERT_FALSE(runs.empty());
+    expect_round_robin();
+}
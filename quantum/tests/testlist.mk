@@ -0,0 +1,3 @@
+TEST_LIST += \
+	spsc_queue \
+	task_scheduler
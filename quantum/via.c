@@ -67,7 +67,7 @@ bool via_eeprom_is_valid(void) {
     uint8_t magic1 = ((p[5] & 0x0F) << 4) | (p[6] & 0x0F);
     uint8_t magic2 = ((p[8] & 0x0F) << 4) | (p[9] & 0x0F);
 
-    return (eeprom_read_byte((void *)VIA_EEPROM_MAGIC_ADDR + 0) == magic0 && eeprom_read_byte((void *)VIA_EEPROM_MAGIC_ADDR + 1) == magic1 && eeprom_read_byte((void *)VIA_EEPROM_MAGIC_ADDR + 2) == magic2);
+    return (eeconfig_read_byte((void *)VIA_EEPROM_MAGIC_ADDR + 0) == magic0 && eeconfig_read_byte((void *)VIA_EEPROM_MAGIC_ADDR + 1) == magic1 && eeconfig_read_byte((void *)VIA_EEPROM_MAGIC_ADDR + 2) == magic2);
 }
 
 // Sets VIA/keyboard level usage of EEPROM to valid/invalid
@@ -78,9 +78,11 @@ void via_eeprom_set_valid(bool valid) {
     uint8_t magic1 = ((p[5] & 0x0F) << 4) | (p[6] & 0x0F);
     uint8_t magic2 = ((p[8] & 0x0F) << 4) | (p[9] & 0x0F);
 
-    eeprom_update_byte((void *)VIA_EEPROM_MAGIC_ADDR + 0, valid ? magic0 : 0xFF);
-    eeprom_update_byte((void *)VIA_EEPROM_MAGIC_ADDR + 1, valid ? magic1 : 0xFF);
-    eeprom_update_byte((void *)VIA_EEPROM_MAGIC_ADDR + 2, valid ? magic2 : 0xFF);
+    eeconfig_update_byte((void *)VIA_EEPROM_MAGIC_ADDR + 0, valid ? magic0 : 0xFF);
+    eeconfig_update_byte((void *)VIA_EEPROM_MAGIC_ADDR + 1, valid ? magic1 : 0xFF);
+    eeconfig_update_byte((void *)VIA_EEPROM_MAGIC_ADDR + 2, valid ? magic2 : 0xFF);
+    // ordered against the dynamic keymap writes, which are not cached
+    eeconfig_flush();
 }
 
 // Override this at the keyboard code level to check
@@ -126,7 +128,7 @@ uint32_t via_get_layout_options(void) {
     void *source = (void *)(VIA_EEPROM_LAYOUT_OPTIONS_ADDR);
     for (uint8_t i = 0; i < VIA_EEPROM_LAYOUT_OPTIONS_SIZE; i++) {
         value = value << 8;
-        value |= eeprom_read_byte(source);
+        value |= eeconfig_read_byte(source);
         source++;
     }
     return value;
@@ -139,7 +141,7 @@ void via_set_layout_options(uint32_t value) {
     // Start at the least significant byte
     void *target = (void *)(VIA_EEPROM_LAYOUT_OPTIONS_ADDR + VIA_EEPROM_LAYOUT_OPTIONS_SIZE - 1);
     for (uint8_t i = 0; i < VIA_EEPROM_LAYOUT_OPTIONS_SIZE; i++) {
-        eeprom_update_byte(target, value & 0xFF);
+        eeconfig_update_byte(target, value & 0xFF);
         value = value >> 8;
         target--;
     }
@@ -192,6 +194,16 @@ __attribute__((weak)) void raw_hid_receive_kb(uint8_t *data, uint8_t length) {
     *command_id         = id_unhandled;
 }
 
+#ifdef VIA_BULK_KEYMAP_ENABLE
+// packets id_dynamic_keymap_bulk_read streams per request
+#    ifndef VIA_BULK_READ_PACKETS
+#        define VIA_BULK_READ_PACKETS 16
+#    endif
+
+// next packet of the keymap stream id_dynamic_keymap_bulk_read will send
+static uint16_t bulk_read_sequence = 0;
+#endif
+
 // VIA handles received HID messages first, and will route to
 // raw_hid_receive_kb() for command IDs that are not handled here.
 // This gives the keyboard code level the ability to handle the command
@@ -377,6 +389,71 @@ void raw_hid_receive(uint8_t *data, uint8_t length) {
             dynamic_keymap_set_buffer(offset, size, &command_data[3]);
             break;
         }
+#ifdef VIA_BULK_KEYMAP_ENABLE
+        case id_dynamic_keymap_get_buffer_crc: {
+            uint16_t size   = dynamic_keymap_get_buffer_size();
+            uint16_t crc    = dynamic_keymap_get_buffer_crc();
+            command_data[0] = size >> 8;
+            command_data[1] = size & 0xFF;
+            command_data[2] = crc >> 8;
+            command_data[3] = crc & 0xFF;
+            break;
+        }
+        case id_dynamic_keymap_bulk_read: {
+            // command_data[0..1] is the sequence number of the first packet the
+            // host wants, 0 restarts the stream. Up to VIA_BULK_READ_PACKETS
+            // packets are streamed without waiting for the host, the last one
+            // is the reply below. Each has its sequence number in
+            // command_data[0..1] and the payload length in command_data[2],
+            // with bit 7 set on the last packet of the stream, or 0xFF if
+            // the stream has no such packet.
+            uint16_t sequence = (command_data[0] << 8) | command_data[1];
+            if (sequence == 0 || sequence < bulk_read_sequence) {
+                dynamic_keymap_encode_begin();
+                bulk_read_sequence = 0;
+            }
+            // re-encode the packets before the one the host resumes from
+            while (bulk_read_sequence < sequence && !dynamic_keymap_encode_done()) {
+                dynamic_keymap_encode(&command_data[3], length - 4);
+                bulk_read_sequence++;
+            }
+            if (bulk_read_sequence != sequence) {
+                command_data[2] = 0xFF;
+                break;
+            }
+            for (uint8_t packets = 1;; packets++) {
+                command_data[0] = bulk_read_sequence >> 8;
+                command_data[1] = bulk_read_sequence & 0xFF;
+                command_data[2] = dynamic_keymap_encode(&command_data[3], length - 4);
+                bulk_read_sequence++;
+                if (dynamic_keymap_encode_done()) {
+                    command_data[2] |= 0x80;
+                    break;
+                }
+                if (packets == VIA_BULK_READ_PACKETS) {
+                    break;
+                }
+                raw_hid_send(data, length);
+            }
+            break;
+        }
+        case id_dynamic_keymap_bulk_write_begin: {
+            dynamic_keymap_decode_begin();
+            break;
+        }
+        case id_dynamic_keymap_bulk_write_data: {
+            uint16_t sequence = (command_data[0] << 8) | command_data[1];
+            uint8_t  size     = command_data[2] < length - 4 ? command_data[2] : length - 4;
+            dynamic_keymap_decode(sequence, &command_data[3], size);
+            // Not acknowledged, errors are reported by id_dynamic_keymap_bulk_write_end
+            return;
+        }
+        case id_dynamic_keymap_bulk_write_end: {
+            uint16_t crc    = (command_data[0] << 8) | command_data[1];
+            command_data[0] = dynamic_keymap_decode_end(crc);
+            break;
+        }
+#endif
         default: {
             // The command ID is not known
             // Return the unhandled state
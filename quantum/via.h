@@ -78,6 +78,11 @@ enum via_command_id {
     id_dynamic_keymap_get_layer_count       = 0x11,
     id_dynamic_keymap_get_buffer            = 0x12,
     id_dynamic_keymap_set_buffer            = 0x13,
+    id_dynamic_keymap_get_buffer_crc        = 0x40,
+    id_dynamic_keymap_bulk_read             = 0x41,
+    id_dynamic_keymap_bulk_write_begin      = 0x42,
+    id_dynamic_keymap_bulk_write_data       = 0x43,
+    id_dynamic_keymap_bulk_write_end        = 0x44,
     id_unhandled                            = 0xFF,
 };
 
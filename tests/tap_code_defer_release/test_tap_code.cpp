@@ -0,0 +1,163 @@
+/* Copyright 2022 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "keyboard_report_util.hpp"
+#include "keycode.h"
+#include "test_common.hpp"
+#include "test_fixture.hpp"
+#include "test_keymap_key.hpp"
+
+using testing::_;
+using testing::InSequence;
+
+extern "C" bool process_record_user(uint16_t keycode, keyrecord_t* record) {
+    if (keycode == KC_F1 && record->event.pressed) {
+        tap_code(KC_A);
+        tap_code(KC_B);
+        tap_code16(S(KC_C));
+        return false;
+    }
+    if (keycode == KC_F2 && record->event.pressed) {
+        tap_code(KC_CAPS_LOCK);
+        return false;
+    }
+    return true;
+}
+
+class TapCodeDeferRelease : public TestFixture {};
+
+TEST_F(TapCodeDeferRelease, taps_are_sent_as_separate_pairs) {
+    TestDriver driver;
+    InSequence s;
+    auto       macro_key = KeymapKey(0, 0, 0, KC_F1);
+
+    set_keymap({macro_key});
+
+    /* Press macro key, only the first tap is sent straight away */
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A)));
+    macro_key.press();
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    /* The rest follow one at a time, each held for TAP_CODE_DELAY */
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_B)));
+    idle_for(TAP_CODE_DELAY);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT, KC_C)));
+    idle_for(TAP_CODE_DELAY);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    idle_for(TAP_CODE_DELAY);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    macro_key.release();
+    idle_for(TAP_CODE_DELAY);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+}
+
+TEST_F(TapCodeDeferRelease, key_press_sends_queued_taps_first) {
+    TestDriver driver;
+    InSequence s;
+    auto       macro_key   = KeymapKey(0, 0, 0, KC_F1);
+    auto       regular_key = KeymapKey(0, 1, 0, KC_X);
+
+    set_keymap({macro_key, regular_key});
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A)));
+    macro_key.press();
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    /* Press regular key, the queued taps are sent before it, each held for its delay */
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_B)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT, KC_C)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_X)));
+    uint32_t pressed = timer_read32();
+    regular_key.press();
+    run_one_scan_loop();
+    EXPECT_GE(timer_elapsed32(pressed), 3 * TAP_CODE_DELAY);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    regular_key.release();
+    run_one_scan_loop();
+    macro_key.release();
+    idle_for(TAP_CODE_DELAY);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+}
+
+TEST_F(TapCodeDeferRelease, key_press_keeps_caps_lock_held) {
+    TestDriver driver;
+    InSequence s;
+    auto       caps_key    = KeymapKey(0, 0, 0, KC_F2);
+    auto       regular_key = KeymapKey(0, 1, 0, KC_X);
+
+    set_keymap({caps_key, regular_key});
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_CAPS_LOCK)));
+    caps_key.press();
+    run_one_scan_loop();
+    uint32_t tapped = timer_read32();
+    caps_key.release();
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    /* Press regular key long before the caps lock tap is due, it is still held for the full delay */
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_X)));
+    regular_key.press();
+    run_one_scan_loop();
+    EXPECT_GE(timer_elapsed32(tapped), TAP_HOLD_CAPS_DELAY);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    regular_key.release();
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+}
+
+TEST_F(TapCodeDeferRelease, clear_keyboard_drops_queued_taps) {
+    TestDriver driver;
+    InSequence s;
+    auto       macro_key = KeymapKey(0, 0, 0, KC_F1);
+
+    set_keymap({macro_key});
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A)));
+    macro_key.press();
+    run_one_scan_loop();
+    macro_key.release();
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    /* Queued release of A is sent, taps not yet started are dropped */
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    clear_keyboard();
+    idle_for(3 * TAP_CODE_DELAY);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+}
@@ -0,0 +1,248 @@
+/* Copyright 2022 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "keyboard_report_util.hpp"
+#include "keycode.h"
+#include "test_common.hpp"
+#include "action_tapping.h"
+#include "test_fixture.hpp"
+#include "test_keymap_key.hpp"
+
+extern "C" {
+#include "predictive_tap_hold.h"
+}
+
+using testing::_;
+using testing::AnyNumber;
+using testing::InSequence;
+
+class PredictiveTapHold : public TestFixture {
+   protected:
+    void SetUp() override {
+        predictive_tap_hold_reset();
+        predictive_tap_hold_enable();
+    }
+
+    /* Roll from the tap-hold key onto the regular key, releasing the tap-hold key first. */
+    void roll(TestDriver& driver, KeymapKey& tap_hold_key, KeymapKey& regular_key, unsigned times) {
+        EXPECT_CALL(driver, send_keyboard_mock(_)).Times(AnyNumber());
+        for (unsigned i = 0; i < times; i++) {
+            tap_hold_key.press();
+            run_one_scan_loop();
+            regular_key.press();
+            run_one_scan_loop();
+            tap_hold_key.release();
+            run_one_scan_loop();
+            regular_key.release();
+            run_one_scan_loop();
+            idle_for(TAPPING_TERM);
+        }
+        testing::Mock::VerifyAndClearExpectations(&driver);
+    }
+};
+
+TEST_F(PredictiveTapHold, untrained_roll_waits_for_release) {
+    TestDriver driver;
+    InSequence s;
+    auto       mod_tap_hold_key = KeymapKey(0, 1, 0, SFT_T(KC_P));
+    auto       regular_key      = KeymapKey(0, 2, 0, KC_A);
+
+    set_keymap({mod_tap_hold_key, regular_key});
+
+    /* Press mod-tap-hold key */
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    mod_tap_hold_key.press();
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    /* Press regular key */
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    regular_key.press();
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    /* Release mod-tap-hold key */
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_P)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_P, KC_A)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A)));
+    mod_tap_hold_key.release();
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    /* Release regular key */
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    regular_key.release();
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    const predictive_tap_hold_stats_t* stats = predictive_tap_hold_get_stats(mod_tap_hold_key.position);
+    ASSERT_NE(stats, nullptr);
+    EXPECT_EQ(stats->tap[0], 1);
+    EXPECT_EQ(stats->hold[0], 0);
+}
+
+TEST_F(PredictiveTapHold, trained_roll_settles_tap_on_next_press) {
+    TestDriver driver;
+    InSequence s;
+    auto       mod_tap_hold_key = KeymapKey(0, 1, 0, SFT_T(KC_P));
+    auto       regular_key      = KeymapKey(0, 2, 0, KC_A);
+
+    set_keymap({mod_tap_hold_key, regular_key});
+
+    roll(driver, mod_tap_hold_key, regular_key, PREDICTIVE_TAP_HOLD_MIN_SAMPLES);
+
+    /* Press mod-tap-hold key */
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    mod_tap_hold_key.press();
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    /* Press regular key, the tap is settled without waiting for the release */
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_P)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A)));
+    regular_key.press();
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    /* Release mod-tap-hold key */
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    mod_tap_hold_key.release();
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    /* Release regular key */
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    regular_key.release();
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+}
+
+TEST_F(PredictiveTapHold, observed_hold_prevents_prediction) {
+    TestDriver driver;
+    InSequence s;
+    auto       mod_tap_hold_key = KeymapKey(0, 1, 0, SFT_T(KC_P));
+    auto       regular_key      = KeymapKey(0, 2, 0, KC_A);
+
+    set_keymap({mod_tap_hold_key, regular_key});
+
+    roll(driver, mod_tap_hold_key, regular_key, PREDICTIVE_TAP_HOLD_MIN_SAMPLES);
+
+    /* Hold the mod-tap-hold key past the tapping term while typing the regular key */
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(AnyNumber());
+    mod_tap_hold_key.press();
+    run_one_scan_loop();
+    regular_key.press();
+    idle_for(TAPPING_TERM);
+    regular_key.release();
+    run_one_scan_loop();
+    mod_tap_hold_key.release();
+    run_one_scan_loop();
+    idle_for(TAPPING_TERM);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    /* Press mod-tap-hold key */
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    mod_tap_hold_key.press();
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    /* Press regular key, one hold in the bin is enough to fall back to waiting */
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    regular_key.press();
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    /* Release mod-tap-hold key */
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_P)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_P, KC_A)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A)));
+    mod_tap_hold_key.release();
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    /* Release regular key */
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    regular_key.release();
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+}
+
+TEST_F(PredictiveTapHold, hold_decision_is_learned_as_hold) {
+    TestDriver driver;
+    auto       mod_tap_hold_key = KeymapKey(0, 1, 0, SFT_T(KC_P));
+    auto       regular_key      = KeymapKey(0, 2, 0, KC_A);
+
+    set_keymap({mod_tap_hold_key, regular_key});
+
+    /* Press the regular key while holding the mod-tap-hold key past the tapping term */
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(AnyNumber());
+    mod_tap_hold_key.press();
+    run_one_scan_loop();
+    regular_key.press();
+    idle_for(TAPPING_TERM);
+    mod_tap_hold_key.release();
+    run_one_scan_loop();
+    regular_key.release();
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    /* The mod-tap-hold key was released first, but the tap-hold logic decided on a hold */
+    const predictive_tap_hold_stats_t* stats = predictive_tap_hold_get_stats(mod_tap_hold_key.position);
+    ASSERT_NE(stats, nullptr);
+    EXPECT_EQ(stats->tap[0], 0);
+    EXPECT_EQ(stats->hold[0], 1);
+}
+
+TEST_F(PredictiveTapHold, overlapping_predictions_swallow_both_releases) {
+    TestDriver driver;
+    InSequence s;
+    auto       first_key   = KeymapKey(0, 1, 0, SFT_T(KC_P));
+    auto       second_key  = KeymapKey(0, 2, 0, CTL_T(KC_O));
+    auto       regular_key = KeymapKey(0, 3, 0, KC_A);
+
+    set_keymap({first_key, second_key, regular_key});
+
+    roll(driver, first_key, second_key, PREDICTIVE_TAP_HOLD_MIN_SAMPLES);
+    roll(driver, second_key, regular_key, PREDICTIVE_TAP_HOLD_MIN_SAMPLES);
+
+    /* Roll over all three keys, both taps are predicted */
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_P)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_O)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A)));
+    first_key.press();
+    run_one_scan_loop();
+    second_key.press();
+    run_one_scan_loop();
+    regular_key.press();
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    /* The releases of both predicted keys are swallowed */
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    first_key.release();
+    run_one_scan_loop();
+    second_key.release();
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    regular_key.release();
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+}
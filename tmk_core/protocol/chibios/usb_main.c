@@ -42,6 +42,7 @@
 #include "usb_device_state.h"
 #include "usb_descriptor.h"
 #include "usb_driver.h"
+#include "spsc_queue.h"
 
 #ifdef NKRO_ENABLE
 #    include "keycode_config.h"
@@ -387,34 +388,19 @@ static usb_driver_configs_t drivers = {
  */
 
 #define USB_EVENT_QUEUE_SIZE 16
-usbevent_t event_queue[USB_EVENT_QUEUE_SIZE];
-uint8_t    event_queue_head;
-uint8_t    event_queue_tail;
+SPSC_QUEUE(event_queue, usbevent_t, USB_EVENT_QUEUE_SIZE);
 
 void usb_event_queue_init(void) {
     // Initialise the event queue
-    memset(&event_queue, 0, sizeof(event_queue));
-    event_queue_head = 0;
-    event_queue_tail = 0;
+    event_queue_clear();
 }
 
 static inline bool usb_event_queue_enqueue(usbevent_t event) {
-    uint8_t next = (event_queue_head + 1) % USB_EVENT_QUEUE_SIZE;
-    if (next == event_queue_tail) {
-        return false;
-    }
-    event_queue[event_queue_head] = event;
-    event_queue_head              = next;
-    return true;
+    return event_queue_push(event);
 }
 
 static inline bool usb_event_queue_dequeue(usbevent_t *event) {
-    if (event_queue_head == event_queue_tail) {
-        return false;
-    }
-    *event           = event_queue[event_queue_tail];
-    event_queue_tail = (event_queue_tail + 1) % USB_EVENT_QUEUE_SIZE;
-    return true;
+    return event_queue_pop(event);
 }
 
 static inline void usb_event_suspend_handler(void) {
@@ -1063,6 +1049,11 @@ int8_t sendchar(uint8_t c) {
     return result;
 }
 
+uint8_t sendchar_buffer(const uint8_t *data, uint8_t length) {
+    /* Only what fits in the output queue right now is taken, so callers are never held up by the host */
+    return chnWriteTimeout(&drivers.console_driver.driver, data, length, TIME_IMMEDIATE);
+}
+
 // Just a dummy function for now, this could be exposed as a weak function
 // Or connected to the actual QMK console
 static void console_receive(uint8_t *data, uint8_t length) {
@@ -858,6 +858,36 @@ ERROR_EXIT:
     Endpoint_SelectEndpoint(ep);
     return -1;
 }
+
+/** \brief Send Buffer
+ *
+ * Writes only what fits in the endpoint bank right now and never waits for the host, unlike sendchar().
+ */
+uint8_t sendchar_buffer(const uint8_t *data, uint8_t length) {
+    if (USB_DeviceState != DEVICE_STATE_Configured) return 0;
+
+    // prevents Console_Task() from flushing the bank while it is written
+    CONSOLE_FLUSH_SET(false);
+
+    uint8_t ep   = Endpoint_GetCurrentEndpoint();
+    uint8_t sent = 0;
+    Endpoint_SelectEndpoint(CONSOLE_IN_EPNUM);
+    if (Endpoint_IsEnabled() && Endpoint_IsConfigured() && Endpoint_IsINReady()) {
+        while (sent < length && Endpoint_IsReadWriteAllowed()) {
+            Endpoint_Write_8(data[sent++]);
+        }
+
+        // send when bank is full, a partial bank is sent by Console_Task()
+        if (!Endpoint_IsReadWriteAllowed()) {
+            Endpoint_ClearIN();
+        } else if (Endpoint_BytesInEndpoint()) {
+            CONSOLE_FLUSH_SET(true);
+        }
+    }
+
+    Endpoint_SelectEndpoint(ep);
+    return sent;
+}
 #endif
 
 /*******************************************************************************
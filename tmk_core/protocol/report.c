@@ -270,6 +270,9 @@ void del_key_from_report(report_keyboard_t* keyboard_report, uint8_t key) {
  */
 void clear_keys_from_report(report_keyboard_t* keyboard_report) {
     // not clear mods
+#ifdef RING_BUFFERED_6KRO_REPORT_ENABLE
+    cb_head = cb_tail = cb_count = 0;
+#endif
 #ifdef NKRO_ENABLE
     if (keyboard_protocol && keymap_config.nkro) {
         memset(keyboard_report->nkro.bits, 0, sizeof(keyboard_report->nkro.bits));
@@ -176,6 +176,11 @@ int8_t sendchar(uint8_t c) {
     return 0;
 }
 
+uint8_t sendchar_buffer(const uint8_t *data, uint8_t length) {
+    // console_task() sends the buffer, what does not fit is left to the caller
+    return rbuf_push_n(data, length);
+}
+
 static inline bool usbSendData3(char *data, uint8_t len) {
     uint8_t retries = 5;
     while (!usbInterruptIsReady3()) {
@@ -1,5 +1,5 @@
 #include "arkag.h"
-#include "eeprom.h"
+#include "eeconfig.h"
 
 /*
  Current Layout and Keeb:
@@ -186,7 +186,7 @@ void flash_rgb (void) {
 void set_os (uint8_t os, bool update) {
   current_os = os;
   if (update) {
-    eeprom_update_byte(EECONFIG_USERSPACE, current_os);
+    eeconfig_update_byte(EECONFIG_USERSPACE, current_os);
   }
   switch (os) {
   case OS_MAC:
@@ -304,7 +304,7 @@ void pri_mod_keystroke(uint16_t key) {
 }
 
 void matrix_init_user(void) {
-  current_os = eeprom_read_byte(EECONFIG_USERSPACE);
+  current_os = eeconfig_read_byte(EECONFIG_USERSPACE);
   set_os(current_os, false);
 }
 
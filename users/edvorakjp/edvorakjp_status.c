@@ -1,4 +1,4 @@
-#include "eeprom.h"
+#include "eeconfig.h"
 #include "edvorakjp.h"
 
 typedef union {
@@ -17,9 +17,9 @@ static edvorakjp_state_t edvorakjp_state;
 /*
  * private methods
  */
-uint8_t eeconfig_read_edvorakjp(void) { return eeprom_read_byte(EECONFIG_EDVORAK); }
+uint8_t eeconfig_read_edvorakjp(void) { return eeconfig_read_byte(EECONFIG_EDVORAK); }
 
-void eeconfig_update_edvorakjp(uint8_t val) { eeprom_update_byte(EECONFIG_EDVORAK, val); }
+void eeconfig_update_edvorakjp(uint8_t val) { eeconfig_update_byte(EECONFIG_EDVORAK, val); }
 
 /*
  * public methods
@@ -1,7 +1,7 @@
 #ifndef LIGHTS_H
 #define LIGHTS_H
 
-#include "eeprom.h"
+#include "eeconfig.h"
 #include "tap_dance.h"
 #include "zer09.h"
 
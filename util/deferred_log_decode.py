@@ -0,0 +1,185 @@
+#!/usr/bin/env python3
+#
+# Copyright 2022 QMK
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 2 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+# Expands the records queued by dlog() (DEFERRED_LOG_ENABLE) back into text.
+#
+# The firmware only sends the address of each format string together with the
+# raw arguments, the strings themselves are read from the firmware ELF:
+#
+#   hid_listen | util/deferred_log_decode.py .build/my_keyboard_default.elf
+#
+# Console bytes that are not part of a record are passed through unchanged.
+# Records are COBS encoded so that they never contain a zero byte, which
+# hid_listen would take for the end of a packet.
+
+import argparse
+import re
+import struct
+import sys
+
+MARKER = 0x1E
+EM_AVR = 83
+SHF_ALLOC = 0x2
+SHT_NOBITS = 8
+
+FORMAT_SPEC = re.compile(r'%([-+ 0#]*\d*(?:\.\d+)?)(hh|h|ll|l|z)?([diouxXcsp%])')
+
+
+class Image:
+    """Allocated sections of an ELF file, addressable by their load address.
+    """
+    def __init__(self, path):
+        with open(path, 'rb') as f:
+            data = f.read()
+
+        if data[:4] != b'\x7fELF' or data[4] != 1 or data[5] != 1:
+            raise ValueError('%s is not a 32 bit little endian ELF file' % path)
+
+        machine, = struct.unpack_from('<H', data, 18)
+        shoff, = struct.unpack_from('<I', data, 32)
+        shentsize, shnum = struct.unpack_from('<HH', data, 46)
+
+        self.pointer_size = 2 if machine == EM_AVR else 4
+        self.int_size = 2 if machine == EM_AVR else 4
+        self.sections = []
+        for i in range(shnum):
+            _, sh_type, flags, addr, offset, size = struct.unpack_from('<IIIIII', data, shoff + i * shentsize)
+            if flags & SHF_ALLOC and sh_type != SHT_NOBITS and size:
+                self.sections.append((addr, data[offset:offset + size]))
+
+    def string(self, address):
+        for start, contents in self.sections:
+            if start <= address < start + len(contents):
+                end = contents.find(b'\0', address - start)
+                if end < 0:
+                    end = len(contents)
+                return contents[address - start:end].decode('utf-8', 'replace')
+        return None
+
+
+def format_record(image, fmt, args):
+    args = list(args)
+
+    def expand(match):
+        flags, length, conversion = match.groups()
+        if conversion == '%':
+            return '%'
+        value = args.pop(0) if args else 0
+        if image.int_size == 2 and length not in ('l', 'll'):
+            value &= 0xFFFF
+            if conversion in 'di' and value & 0x8000:
+                value -= 0x10000
+        elif conversion in 'di' and value & 0x80000000:
+            value -= 0x100000000
+        if conversion == 's':
+            text = image.string(value)
+            return ('%' + flags + 's') % (text if text is not None else '<0x%X>' % value)
+        if conversion == 'c':
+            return ('%' + flags + 'c') % chr(value & 0xFF)
+        if conversion == 'p':
+            return '0x%X' % value
+        if conversion in 'iu':
+            conversion = 'd'
+        return ('%' + flags + conversion) % value
+
+    return FORMAT_SPEC.sub(expand, fmt)
+
+
+def cobs_decode(data):
+    """Undoes the COBS encoding of a record body, None if it is malformed.
+    """
+    decoded = bytearray()
+    i = 0
+    while i < len(data):
+        code = data[i]
+        if code == 0 or i + code > len(data):
+            return None
+        decoded += data[i + 1:i + code]
+        i += code
+        if i < len(data):
+            decoded.append(0)
+    return bytes(decoded)
+
+
+def decode(image, stream, out):
+    header = 2 + image.pointer_size
+    buffer = b''
+    line_start = True
+
+    def emit(time, message):
+        # records continuing a line, like the pieces of debug_record(), are not stamped again
+        nonlocal line_start
+        out.write(('[%5u] ' % time if line_start else '') + message)
+        line_start = message.endswith('\n')
+
+    while True:
+        chunk = stream.read1(4096) if hasattr(stream, 'read1') else stream.read(4096)
+        if not chunk:
+            break
+        buffer += chunk
+        text = bytearray()
+        while buffer:
+            if buffer[0] != MARKER:
+                text.append(buffer[0])
+                buffer = buffer[1:]
+                continue
+            if len(buffer) < 2 or len(buffer) < 2 + buffer[1]:
+                break  # wait for the rest of the record
+
+            length = buffer[1]
+            payload = cobs_decode(buffer[2:2 + length])
+            if payload is None or len(payload) < header or (len(payload) - header) % 4:
+                # not a record, a stray marker byte in the plain text
+                text.append(buffer[0])
+                buffer = buffer[1:]
+                continue
+
+            time, = struct.unpack_from('<H', payload, 0)
+            address = int.from_bytes(payload[2:header], 'little')
+            args = struct.unpack_from('<%dI' % ((len(payload) - header) // 4), payload, header)
+            buffer = buffer[2 + length:]
+
+            if text:
+                out.write(text.decode('utf-8', 'replace'))
+                line_start = text.endswith(b'\n')
+                text = bytearray()
+            if address == 0:
+                emit(time, '<%u log records dropped>\n' % (args[0] if args else 0))
+                continue
+            fmt = image.string(address)
+            if fmt is None:
+                emit(time, '<unknown format 0x%X %s>\n' % (address, ' '.join('%X' % a for a in args)))
+                continue
+            emit(time, format_record(image, fmt, args))
+        if text:
+            out.write(text.decode('utf-8', 'replace'))
+            line_start = text.endswith(b'\n')
+        out.flush()
+
+
+if __name__ == '__main__':
+    parser = argparse.ArgumentParser(description='Decode deferred log records from the QMK console.')
+    parser.add_argument('elf', help='firmware ELF the keyboard is running')
+    parser.add_argument('input', nargs='?', help='captured console output, stdin if omitted')
+    args = parser.parse_args()
+
+    image = Image(args.elf)
+    if args.input:
+        with open(args.input, 'rb') as stream:
+            decode(image, stream, sys.stdout)
+    else:
+        decode(image, sys.stdin.buffer, sys.stdout)